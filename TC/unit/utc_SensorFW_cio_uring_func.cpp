@@ -0,0 +1,268 @@
+#include <tet_api.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "cio_uring.h"
+
+#define MSG_NUM			16
+#define MSG_SIZE		48
+
+static int g_sv[2] = { -1, -1 };
+
+static void startup(void);
+static void cleanup(void);
+
+extern "C" {
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+}
+
+static void utc_SensorFW_cio_uring_func_01(void);
+static void utc_SensorFW_cio_uring_func_02(void);
+static void utc_SensorFW_cio_uring_func_03(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+extern "C" {
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_cio_uring_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_cio_uring_func_02, POSITIVE_TC_IDX },
+	{ utc_SensorFW_cio_uring_func_03, NEGATIVE_TC_IDX },
+	{ NULL, 0},
+};
+}
+
+/* tet_startup runs once for all test cases, every case starts from a fresh socket pair */
+static bool pair_reset(void)
+{
+	if (g_sv[0] >= 0)
+		close(g_sv[0]);
+	if (g_sv[1] >= 0)
+		close(g_sv[1]);
+
+	return socketpair(AF_UNIX, SOCK_STREAM, 0, g_sv) == 0;
+}
+
+/* a ring the kernel refuses must refuse every operation, the caller then keeps its socket calls */
+static bool check_unready(cio_uring *ring)
+{
+	unsigned long long user_data;
+	char buf[4];
+	int res;
+
+	tet_infoline("io_uring is not available, checking the fallback contract only");
+
+	if (ring->is_ready() || ring->prep_send(g_sv[0], buf, sizeof(buf), 0, true)
+		|| ring->prep_recv(g_sv[1], buf, sizeof(buf), 0) || ring->reap(&user_data, &res)
+		|| ring->submit_and_wait(1) != -1) {
+		tet_infoline("an unready ring accepted an operation");
+		return false;
+	}
+
+	return true;
+}
+
+static void startup(void)
+{
+}
+
+static void cleanup(void)
+{
+	if (g_sv[0] >= 0)
+		close(g_sv[0]);
+	if (g_sv[1] >= 0)
+		close(g_sv[1]);
+}
+
+/**
+ * @brief A send linked to a receive completes both in one submit_and_wait(), with the data intact
+ */
+static void utc_SensorFW_cio_uring_func_01(void)
+{
+	cio_uring ring;
+	char send_buf[MSG_SIZE];
+	char recv_buf[MSG_SIZE];
+	unsigned long long user_data;
+	unsigned int enters;
+	char info[128];
+	int done = 0;
+	int res;
+
+	if (!pair_reset()) {
+		tet_infoline("socketpair fail");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	if (!ring.init(8)) {
+		tet_result(check_unready(&ring) ? TET_PASS : TET_FAIL);
+		return;
+	}
+
+	memset(send_buf, 0x5a, sizeof(send_buf));
+	memset(recv_buf, 0, sizeof(recv_buf));
+	enters = ring.enters();
+
+	if (!ring.prep_send(g_sv[0], send_buf, sizeof(send_buf), 1, true)
+		|| !ring.prep_recv(g_sv[1], recv_buf, sizeof(recv_buf), 2)
+		|| ring.submit_and_wait(2) < 0) {
+		tet_infoline("cannot submit a linked send and receive");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	while (ring.reap(&user_data, &res)) {
+		if (res != MSG_SIZE || (user_data != 1 && user_data != 2)) {
+			snprintf(info, sizeof(info), "completion %llu , res : %d", user_data, res);
+			tet_infoline(info);
+			tet_result(TET_FAIL);
+			return;
+		}
+		done |= (int)user_data;
+	}
+
+	if (done != 3 || memcmp(send_buf, recv_buf, sizeof(send_buf))) {
+		tet_infoline("send and receive did not both complete with the data");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	if (ring.enters() - enters != 1) {
+		snprintf(info, sizeof(info), "%u io_uring_enter for one submission", ring.enters() - enters);
+		tet_infoline(info);
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief More operations than the ring holds go through in rounds, every one completing once
+ */
+static void utc_SensorFW_cio_uring_func_02(void)
+{
+	cio_uring ring;
+	char send_buf[MSG_NUM][MSG_SIZE];
+	char recv_buf[MSG_NUM * MSG_SIZE];
+	unsigned long long user_data;
+	unsigned int received = 0;
+	int completed[MSG_NUM];
+	int queued;
+	int res;
+	int i;
+
+	if (!pair_reset()) {
+		tet_infoline("socketpair fail");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	if (!ring.init(4)) {
+		tet_result(check_unready(&ring) ? TET_PASS : TET_FAIL);
+		return;
+	}
+
+	for (i = 0; i < MSG_NUM; i++) {
+		memset(send_buf[i], i, MSG_SIZE);
+		completed[i] = 0;
+	}
+
+	for (i = 0; i < MSG_NUM; ) {
+		for (queued = 0; i < MSG_NUM && ring.prep_send(g_sv[0], send_buf[i], MSG_SIZE, i, false); i++)
+			queued++;
+
+		if (!queued || ring.submit_and_wait(queued) < 0) {
+			tet_infoline("cannot submit sends");
+			tet_result(TET_FAIL);
+			return;
+		}
+
+		while (ring.reap(&user_data, &res)) {
+			if (user_data >= MSG_NUM || res != MSG_SIZE) {
+				tet_infoline("unexpected send completion");
+				tet_result(TET_FAIL);
+				return;
+			}
+			completed[user_data]++;
+		}
+	}
+
+	while (received < sizeof(recv_buf)) {
+		res = recv(g_sv[1], recv_buf + received, sizeof(recv_buf) - received, 0);
+		if (res <= 0) {
+			tet_infoline("peer did not get every send");
+			tet_result(TET_FAIL);
+			return;
+		}
+		received += res;
+	}
+
+	for (i = 0; i < MSG_NUM; i++) {
+		if (completed[i] != 1 || memcmp(recv_buf + i * MSG_SIZE, send_buf[i], MSG_SIZE)) {
+			tet_infoline("a send completed twice, never, or out of order");
+			tet_result(TET_FAIL);
+			return;
+		}
+	}
+
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief A failed send cancels the receive linked to it instead of leaving it waiting
+ */
+static void utc_SensorFW_cio_uring_func_03(void)
+{
+	cio_uring ring;
+	char send_buf[MSG_SIZE];
+	char recv_buf[MSG_SIZE];
+	unsigned long long user_data;
+	int send_res = 0;
+	int recv_res = 0;
+	int res;
+
+	if (!pair_reset()) {
+		tet_infoline("socketpair fail");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	if (!ring.init(8)) {
+		tet_result(check_unready(&ring) ? TET_PASS : TET_FAIL);
+		return;
+	}
+
+	memset(send_buf, 0, sizeof(send_buf));
+	shutdown(g_sv[0], SHUT_WR);
+
+	if (!ring.prep_send(g_sv[0], send_buf, sizeof(send_buf), 1, true)
+		|| !ring.prep_recv(g_sv[0], recv_buf, sizeof(recv_buf), 2)
+		|| ring.submit_and_wait(2) < 0) {
+		tet_infoline("cannot submit a linked send and receive");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	while (ring.reap(&user_data, &res)) {
+		if (user_data == 1)
+			send_res = res;
+		else if (user_data == 2)
+			recv_res = res;
+	}
+
+	if (send_res != -EPIPE || recv_res != -ECANCELED) {
+		tet_infoline("the receive linked to a failed send was not cancelled");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	tet_result(TET_PASS);
+}
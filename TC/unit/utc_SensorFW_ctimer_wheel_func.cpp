@@ -0,0 +1,265 @@
+#include <tet_api.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ctimer_wheel.h"
+
+#define TIMER_NUM		64
+#define SPARSE_TIMER_NUM	6
+#define WAKEUP_NUM		200000
+#define EXPIRY_NONE		(~0ULL)
+
+/* starts just before a level 1 boundary, where the wheel used to lose entries */
+#define CLOCK_START		(1009984ULL - 40)
+
+struct wheel_timer {
+	ctimer_wheel::entry e;
+	ctimer_wheel *wheel;
+	unsigned long long period;
+	unsigned long long expected;
+	int fired;
+	int late;
+};
+
+static unsigned long long g_now;
+static struct wheel_timer g_timer[TIMER_NUM];
+
+static unsigned long long fake_clock(void)
+{
+	return g_now;
+}
+
+static void periodic_cb(void *user_data)
+{
+	struct wheel_timer *timer = (struct wheel_timer *)user_data;
+
+	if (g_now != timer->expected)
+		timer->late++;
+
+	timer->fired++;
+	timer->expected += timer->period;
+	timer->wheel->add_at(&timer->e, timer->expected);
+}
+
+static void oneshot_cb(void *user_data)
+{
+	struct wheel_timer *timer = (struct wheel_timer *)user_data;
+
+	timer->fired++;
+}
+
+static unsigned long long earliest(void)
+{
+	unsigned long long expiry = EXPIRY_NONE;
+	int i;
+
+	for (i = 0; i < TIMER_NUM; i++) {
+		if (g_timer[i].e.is_armed() && g_timer[i].expected < expiry)
+			expiry = g_timer[i].expected;
+	}
+
+	return expiry;
+}
+
+static void startup(void);
+static void cleanup(void);
+
+extern "C" {
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+}
+
+static void utc_SensorFW_ctimer_wheel_func_01(void);
+static void utc_SensorFW_ctimer_wheel_func_02(void);
+static void utc_SensorFW_ctimer_wheel_func_03(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+extern "C" {
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_ctimer_wheel_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_ctimer_wheel_func_02, POSITIVE_TC_IDX },
+	{ utc_SensorFW_ctimer_wheel_func_03, POSITIVE_TC_IDX },
+	{ NULL, 0},
+};
+}
+
+/* tet_startup runs once for all test cases, every case starts from fresh timers */
+static void timers_reset(void)
+{
+	int i;
+
+	g_now = CLOCK_START;
+
+	for (i = 0; i < TIMER_NUM; i++) {
+		g_timer[i].e = ctimer_wheel::entry();
+		g_timer[i].wheel = NULL;
+		g_timer[i].period = 0;
+		g_timer[i].expected = 0;
+		g_timer[i].fired = 0;
+		g_timer[i].late = 0;
+	}
+}
+
+static void startup(void)
+{
+}
+
+static void cleanup(void)
+{
+}
+
+/**
+ * @brief Periodic timers of 96 ms to 6 s fire exactly on time when the loop wakes only at next_expiry()
+ */
+static void utc_SensorFW_ctimer_wheel_func_01(void)
+{
+	ctimer_wheel wheel;
+	unsigned int seed = 27;
+	unsigned long long expiry;
+	char info[128];
+	int i;
+
+	timers_reset();
+	wheel.set_clock(fake_clock);
+
+	/* few timers, so that level 0 is often empty and the next expiry sits in an upper level */
+	for (i = 0; i < SPARSE_TIMER_NUM; i++) {
+		if (i == 0)
+			g_timer[i].period = 96;
+		else if (i == 1)
+			g_timer[i].period = 193;
+		else
+			g_timer[i].period = 64 + rand_r(&seed) % 6000;
+
+		g_timer[i].wheel = &wheel;
+		g_timer[i].e.cb = periodic_cb;
+		g_timer[i].e.user_data = &g_timer[i];
+		g_timer[i].expected = g_now + g_timer[i].period;
+		wheel.add_at(&g_timer[i].e, g_timer[i].expected);
+	}
+
+	for (i = 0; i < WAKEUP_NUM; i++) {
+		expiry = wheel.next_expiry();
+		if (expiry != earliest()) {
+			snprintf(info, sizeof(info), "next_expiry %llu, earliest %llu at %llu",
+				expiry, earliest(), g_now);
+			tet_infoline(info);
+			tet_result(TET_FAIL);
+			return;
+		}
+
+		g_now = expiry;
+		wheel.run(0);
+	}
+
+	for (i = 0; i < SPARSE_TIMER_NUM; i++) {
+		if (g_timer[i].late || !g_timer[i].fired) {
+			snprintf(info, sizeof(info), "timer of %llu ms fired %d times, %d late",
+				g_timer[i].period, g_timer[i].fired, g_timer[i].late);
+			tet_infoline(info);
+			tet_result(TET_FAIL);
+			return;
+		}
+	}
+
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Wakeups between expiries, as other sources of the loop cause, neither fire early nor lose timers
+ */
+static void utc_SensorFW_ctimer_wheel_func_02(void)
+{
+	ctimer_wheel wheel;
+	unsigned int seed = 36;
+	unsigned long long expiry;
+	char info[128];
+	int i;
+
+	timers_reset();
+	wheel.set_clock(fake_clock);
+
+	for (i = 0; i < TIMER_NUM; i++) {
+		g_timer[i].period = 1 + rand_r(&seed) % 5000;
+		g_timer[i].wheel = &wheel;
+		g_timer[i].e.cb = periodic_cb;
+		g_timer[i].e.user_data = &g_timer[i];
+		g_timer[i].expected = g_now + g_timer[i].period;
+		wheel.add_at(&g_timer[i].e, g_timer[i].expected);
+	}
+
+	for (i = 0; i < WAKEUP_NUM; i++) {
+		expiry = wheel.next_expiry();
+		if (expiry != earliest()) {
+			snprintf(info, sizeof(info), "next_expiry %llu, earliest %llu at %llu",
+				expiry, earliest(), g_now);
+			tet_infoline(info);
+			tet_result(TET_FAIL);
+			return;
+		}
+
+		if (rand_r(&seed) % 2)
+			g_now += rand_r(&seed) % (expiry - g_now + 1);
+		else
+			g_now = expiry;
+
+		wheel.run(0);
+	}
+
+	for (i = 0; i < TIMER_NUM; i++) {
+		if (g_timer[i].late) {
+			snprintf(info, sizeof(info), "timer of %llu ms fired %d times, %d late",
+				g_timer[i].period, g_timer[i].fired, g_timer[i].late);
+			tet_infoline(info);
+			tet_result(TET_FAIL);
+			return;
+		}
+	}
+
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief A cancelled timer never fires and an empty wheel has no expiry
+ */
+static void utc_SensorFW_ctimer_wheel_func_03(void)
+{
+	ctimer_wheel wheel;
+
+	timers_reset();
+	wheel.set_clock(fake_clock);
+
+	g_timer[0].e.cb = oneshot_cb;
+	g_timer[0].e.user_data = &g_timer[0];
+	g_timer[1].e.cb = oneshot_cb;
+	g_timer[1].e.user_data = &g_timer[1];
+
+	wheel.add_at(&g_timer[0].e, g_now + 100);
+	wheel.add_at(&g_timer[1].e, g_now + 5000);
+	wheel.cancel(&g_timer[0].e);
+
+	if (wheel.next_expiry() != g_now + 5000) {
+		tet_infoline("next_expiry() still counts a cancelled timer");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	g_now += 5000;
+	if ((wheel.run(0) != 1) || g_timer[0].fired || (g_timer[1].fired != 1)) {
+		tet_infoline("run() did not fire exactly the armed timer");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	if (wheel.count() || (wheel.next_expiry() != EXPIRY_NONE)) {
+		tet_infoline("empty wheel still has an expiry");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	tet_result(TET_PASS);
+}
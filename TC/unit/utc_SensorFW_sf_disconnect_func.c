@@ -13,6 +13,7 @@ void (*tet_cleanup)(void) = cleanup;
 
 static void utc_SensorFW_sf_disconnect_func_01(void);
 static void utc_SensorFW_sf_disconnect_func_02(void);
+static void utc_SensorFW_sf_disconnect_func_03(void);
 
 enum {
 	POSITIVE_TC_IDX = 0x01,
@@ -22,6 +23,7 @@ enum {
 struct tet_testlist tet_testlist[] = {
 	{ utc_SensorFW_sf_disconnect_func_01, POSITIVE_TC_IDX },
 	{ utc_SensorFW_sf_disconnect_func_02, NEGATIVE_TC_IDX },
+	{ utc_SensorFW_sf_disconnect_func_03, NEGATIVE_TC_IDX },
 	{ NULL, 0},
 };
 
@@ -71,3 +73,27 @@ static void utc_SensorFW_sf_disconnect_func_02(void)
 	}
 	tet_result(TET_PASS);
 }
+
+/**
+ * @brief Negative test case of sf_disconnect() with a handle whose slot was reused
+ */
+static void utc_SensorFW_sf_disconnect_func_03(void)
+{
+	int r = 0;
+	int stale_handle;
+	int reuse_handle;
+
+	stale_handle = sf_connect(ACCELEROMETER_SENSOR);
+	sf_disconnect(stale_handle);
+	reuse_handle = sf_connect(ACCELEROMETER_SENSOR);
+
+	r = sf_disconnect(stale_handle);
+	sf_disconnect(reuse_handle);
+
+	if (r == 0) {
+		tet_infoline("sf_disconnect() failed in negative test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
@@ -0,0 +1,77 @@
+#include <tet_api.h>
+#include <sensor.h>
+
+int group = 0;
+int accel_handle = 0;
+int gyro_handle = 0;
+
+static void startup(void);
+static void cleanup(void);
+
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+
+static void utc_SensorFW_sf_group_start_func_01(void);
+static void utc_SensorFW_sf_group_start_func_02(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_sf_group_start_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_sf_group_start_func_02, NEGATIVE_TC_IDX },
+	{ NULL, 0},
+};
+
+static void startup(void)
+{
+	group = sf_create_group();
+	accel_handle = sf_connect(ACCELEROMETER_SENSOR);
+	gyro_handle = sf_connect(GYROSCOPE_SENSOR);
+	sf_group_add(group, accel_handle);
+	sf_group_add(group, gyro_handle);
+}
+
+static void cleanup(void)
+{
+	sf_group_stop(group);
+	sf_disconnect(accel_handle);
+	sf_disconnect(gyro_handle);
+	sf_destroy_group(group);
+}
+
+/**
+ * @brief Positive test case of sf_group_start()
+ */
+static void utc_SensorFW_sf_group_start_func_01(void)
+{
+	int r = 0;
+
+	r = sf_group_start(group, SENSOR_OPTION_DEFAULT);
+
+	if (r < 0) {
+		tet_infoline("sf_group_start() failed in positive test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Negative test case of ug_init sf_group_start()
+ */
+static void utc_SensorFW_sf_group_start_func_02(void)
+{
+	int r = 0;
+
+	r = sf_group_start(400, SENSOR_OPTION_DEFAULT);
+
+	if (r >= 0) {
+		tet_infoline("sf_group_start() failed in negative test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
@@ -0,0 +1,250 @@
+#include <tet_api.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <glib.h>
+#include <sensor.h>
+#include <sensor_record.h>
+
+#define RECORD_PATH		"/tmp/utc_sf_record_start_03.bin"
+
+int handle = 0;
+int record_handle = 0;
+unsigned int record_callback_num = 0;
+
+void my_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+}
+
+void record_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+	record_callback_num++;
+}
+
+static gboolean quit_loop(gpointer data)
+{
+	g_main_loop_quit((GMainLoop *)data);
+	return FALSE;
+}
+
+/* header of chunk 0, then one data_id per chunk with its time stamps in order */
+static int check_record_file(const char *path, unsigned int *sample_total)
+{
+	const sensor_record_header_t *header;
+	const sensor_record_chunk_t *chunk;
+	const unsigned long long *time_stamp;
+	unsigned long long prev_first_ts = 0;
+	struct stat st;
+	char info[128];
+	void *map;
+	unsigned int i;
+	unsigned int j;
+	int fd;
+	int ret = -1;
+
+	*sample_total = 0;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		tet_infoline("cannot open the record file");
+		return -1;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < SENSOR_RECORD_CHUNK_SIZE) {
+		tet_infoline("the record file has no header chunk");
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		tet_infoline("cannot map the record file");
+		return -1;
+	}
+
+	header = (const sensor_record_header_t *)map;
+
+	if (memcmp(header->magic, SENSOR_RECORD_MAGIC, sizeof(header->magic)) ||
+		header->version != SENSOR_RECORD_VERSION ||
+		header->chunk_size != SENSOR_RECORD_CHUNK_SIZE ||
+		header->chunk_num < 2 ||
+		(off_t)header->chunk_num * SENSOR_RECORD_CHUNK_SIZE != st.st_size) {
+		snprintf(info, sizeof(info), "bad header , version : %u , chunk_size : %u , chunk_num : %u , file size : %ld",
+			header->version, header->chunk_size, header->chunk_num, (long)st.st_size);
+		tet_infoline(info);
+		goto out;
+	}
+
+	for (i = 1; i < header->chunk_num; i++) {
+		chunk = SENSOR_RECORD_CHUNK(map, i);
+		time_stamp = SENSOR_RECORD_TIME_STAMPS(chunk);
+
+		if (chunk->data_id != SENSOR_RECORD_CHUNK(map, 1)->data_id ||
+			!chunk->values_num || !chunk->sample_num || chunk->sample_num > chunk->sample_max ||
+			(char *)(SENSOR_RECORD_ACCURACY(chunk) + chunk->sample_max) > (char *)chunk + SENSOR_RECORD_CHUNK_SIZE ||
+			chunk->first_ts > chunk->last_ts || chunk->first_ts < prev_first_ts ||
+			time_stamp[0] != chunk->first_ts || time_stamp[chunk->sample_num - 1] != chunk->last_ts) {
+			snprintf(info, sizeof(info), "bad chunk %u , data_id : %u , sample_num : %u , sample_max : %u",
+				i, chunk->data_id, chunk->sample_num, chunk->sample_max);
+			tet_infoline(info);
+			goto out;
+		}
+
+		for (j = 1; j < chunk->sample_num; j++) {
+			if (time_stamp[j] < time_stamp[j - 1]) {
+				snprintf(info, sizeof(info), "time stamps of chunk %u go back at sample %u", i, j);
+				tet_infoline(info);
+				goto out;
+			}
+		}
+
+		if (sensor_record_seek(map, chunk->first_ts) < i) {
+			snprintf(info, sizeof(info), "sensor_record_seek() does not find chunk %u", i);
+			tet_infoline(info);
+			goto out;
+		}
+
+		prev_first_ts = chunk->first_ts;
+		*sample_total += chunk->sample_num;
+	}
+
+	if (SENSOR_RECORD_CHUNK(map, 1)->first_ts && sensor_record_seek(map, SENSOR_RECORD_CHUNK(map, 1)->first_ts - 1)) {
+		tet_infoline("sensor_record_seek() finds a chunk before the first sample");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	munmap(map, st.st_size);
+	return ret;
+}
+
+static void startup(void);
+static void cleanup(void);
+
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+
+static void utc_SensorFW_sf_record_start_func_01(void);
+static void utc_SensorFW_sf_record_start_func_02(void);
+static void utc_SensorFW_sf_record_start_func_03(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_sf_record_start_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_sf_record_start_func_02, NEGATIVE_TC_IDX },
+	{ utc_SensorFW_sf_record_start_func_03, POSITIVE_TC_IDX },
+	{ NULL, 0},
+};
+
+static void startup(void)
+{
+	handle = sf_connect(ACCELEROMETER_SENSOR);
+	sf_register_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, NULL, my_callback_func, NULL);
+}
+
+static void cleanup(void)
+{
+	sf_record_stop(handle, 0);
+	sf_unregister_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(handle);
+}
+
+/**
+ * @brief Positive test case of sf_record_start()
+ */
+static void utc_SensorFW_sf_record_start_func_01(void)
+{
+	int r = 0;
+
+	r = sf_record_start(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, "/tmp/utc_sf_record_start.bin");
+
+	if (r < 0) {
+		tet_infoline("sf_record_start() failed in positive test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Negative test case of ug_init sf_record_start()
+ */
+static void utc_SensorFW_sf_record_start_func_02(void)
+{
+	int r = 0;
+
+	r = sf_record_start(handle, ACCELEROMETER_EVENT_ROTATION_CHECK, "/tmp/utc_sf_record_start.bin");
+
+	if (r >= 0) {
+		tet_infoline("sf_record_start() failed in negative test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Every sample called back is in the file after sf_record_stop(), in the layout of sensor_record.h
+ */
+static void utc_SensorFW_sf_record_start_func_03(void)
+{
+	event_condition_t condition;
+	unsigned int sample_total;
+	GMainLoop *loop;
+	char info[128];
+
+	condition.cond_op = CONDITION_EQUAL;
+	condition.cond_value1 = 20;
+
+	record_handle = sf_connect(ACCELEROMETER_SENSOR);
+	if (record_handle < 0 ||
+		sf_register_event(record_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, &condition, record_callback_func, NULL) < 0 ||
+		sf_record_start(record_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, RECORD_PATH) < 0 ||
+		sf_start(record_handle, 0) < 0) {
+		tet_infoline("cannot start a recorded event");
+		tet_result(TET_FAIL);
+		sf_disconnect(record_handle);
+		return;
+	}
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_timeout_add(1000, quit_loop, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+
+	/* samples are recorded as they are queued, so every callback seen so far has its sample in the file */
+	if (sf_record_stop(record_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME) < 0) {
+		tet_infoline("sf_record_stop() failed");
+		tet_result(TET_FAIL);
+		sf_disconnect(record_handle);
+		return;
+	}
+
+	sf_unregister_event(record_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(record_handle);
+
+	if (check_record_file(RECORD_PATH, &sample_total) < 0) {
+		tet_result(TET_FAIL);
+		unlink(RECORD_PATH);
+		return;
+	}
+	unlink(RECORD_PATH);
+
+	if (!record_callback_num || sample_total < record_callback_num) {
+		snprintf(info, sizeof(info), "%u samples recorded for %u callbacks", sample_total, record_callback_num);
+		tet_infoline(info);
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
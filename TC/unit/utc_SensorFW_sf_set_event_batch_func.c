@@ -0,0 +1,140 @@
+#include <tet_api.h>
+#include <glib.h>
+#include <sensor.h>
+
+int handle = 0;
+int batch_handle = 0;
+int batch_num = 0;
+int batch_num_at_stop = -1;
+unsigned int batch_sample_num = 0;
+
+void my_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+}
+
+void batch_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+	batch_num++;
+	batch_sample_num += event->event_data_size / sizeof(sensor_data_t);
+}
+
+static gboolean stop_batch_sensor(gpointer data)
+{
+	batch_num_at_stop = batch_num;
+	sf_stop(batch_handle);
+	return FALSE;
+}
+
+static gboolean quit_loop(gpointer data)
+{
+	g_main_loop_quit((GMainLoop *)data);
+	return FALSE;
+}
+
+static void startup(void);
+static void cleanup(void);
+
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+
+static void utc_SensorFW_sf_set_event_batch_func_01(void);
+static void utc_SensorFW_sf_set_event_batch_func_02(void);
+static void utc_SensorFW_sf_set_event_batch_func_03(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_sf_set_event_batch_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_sf_set_event_batch_func_02, NEGATIVE_TC_IDX },
+	{ utc_SensorFW_sf_set_event_batch_func_03, POSITIVE_TC_IDX },
+	{ NULL, 0},
+};
+
+static void startup(void)
+{
+	handle = sf_connect(ACCELEROMETER_SENSOR);
+	sf_register_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, NULL, my_callback_func, NULL);
+}
+
+static void cleanup(void)
+{
+	sf_unregister_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(handle);
+}
+
+/**
+ * @brief Positive test case of sf_set_event_batch()
+ */
+static void utc_SensorFW_sf_set_event_batch_func_01(void)
+{
+	int r = 0;
+
+	r = sf_set_event_batch(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, 1000);
+
+	if (r < 0) {
+		tet_infoline("sf_set_event_batch() failed in positive test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Negative test case of ug_init sf_set_event_batch()
+ */
+static void utc_SensorFW_sf_set_event_batch_func_02(void)
+{
+	int r = 0;
+
+	r = sf_set_event_batch(handle, ACCELEROMETER_EVENT_ROTATION_CHECK, 1000);
+
+	if (r >= 0) {
+		tet_infoline("sf_set_event_batch() failed in negative test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Samples of an open batch are delivered at max_latency after the sensor stops
+ */
+static void utc_SensorFW_sf_set_event_batch_func_03(void)
+{
+	event_condition_t condition;
+	GMainLoop *loop;
+
+	condition.cond_op = CONDITION_EQUAL;
+	condition.cond_value1 = 20;
+
+	batch_handle = sf_connect(ACCELEROMETER_SENSOR);
+	if (batch_handle < 0 ||
+		sf_register_event(batch_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, &condition, batch_callback_func, NULL) < 0 ||
+		sf_set_event_batch(batch_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, 1000) < 0 ||
+		sf_start(batch_handle, 0) < 0) {
+		tet_infoline("cannot start a batched event");
+		tet_result(TET_FAIL);
+		sf_disconnect(batch_handle);
+		return;
+	}
+
+	/* stop within the first batch, no sample closes it afterwards */
+	loop = g_main_loop_new(NULL, FALSE);
+	g_timeout_add(300, stop_batch_sensor, NULL);
+	g_timeout_add(1600, quit_loop, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+
+	sf_unregister_event(batch_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(batch_handle);
+
+	if (batch_num_at_stop != 0 || batch_num != 1 || !batch_sample_num) {
+		tet_infoline("sf_set_event_batch() did not flush the batch at its deadline");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
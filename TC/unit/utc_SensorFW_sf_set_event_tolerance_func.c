@@ -0,0 +1,178 @@
+#include <tet_api.h>
+#include <stdio.h>
+#include <glib.h>
+#include <sensor.h>
+
+#define TICK_INTERVAL		100
+#define TICK_MAX			32
+#define LATENESS_MAX		15
+
+int handle = 0;
+gint64 tick_time[TICK_MAX];
+int tick_num = 0;
+
+void my_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+}
+
+void tick_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+	if (tick_num < TICK_MAX)
+		tick_time[tick_num++] = g_get_monotonic_time();
+}
+
+static gboolean quit_loop(gpointer data)
+{
+	g_main_loop_quit((GMainLoop *)data);
+	return FALSE;
+}
+
+static void startup(void);
+static void cleanup(void);
+
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+
+static void utc_SensorFW_sf_set_event_tolerance_func_01(void);
+static void utc_SensorFW_sf_set_event_tolerance_func_02(void);
+static void utc_SensorFW_sf_set_event_tolerance_func_03(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_sf_set_event_tolerance_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_sf_set_event_tolerance_func_02, NEGATIVE_TC_IDX },
+	{ utc_SensorFW_sf_set_event_tolerance_func_03, POSITIVE_TC_IDX },
+	{ NULL, 0},
+};
+
+static void startup(void)
+{
+	handle = sf_connect(ACCELEROMETER_SENSOR);
+	sf_register_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, NULL, my_callback_func, NULL);
+}
+
+static void cleanup(void)
+{
+	sf_unregister_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(handle);
+}
+
+/**
+ * @brief Positive test case of sf_set_event_tolerance()
+ */
+static void utc_SensorFW_sf_set_event_tolerance_func_01(void)
+{
+	int r = 0;
+
+	r = sf_set_event_tolerance(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, 20);
+
+	if (r < 0) {
+		tet_infoline("sf_set_event_tolerance() failed in positive test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Negative test case of ug_init sf_set_event_tolerance()
+ */
+static void utc_SensorFW_sf_set_event_tolerance_func_02(void)
+{
+	int r = 0;
+
+	r = sf_set_event_tolerance(handle, ACCELEROMETER_EVENT_ROTATION_CHECK, 20);
+
+	if (r >= 0) {
+		tet_infoline("sf_set_event_tolerance() failed in negative test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief A subscription registered after sf_disconnect() does not inherit the tolerance of the one before it
+ */
+static void utc_SensorFW_sf_set_event_tolerance_func_03(void)
+{
+	event_condition_t condition;
+	event_condition_t fast_condition;
+	GMainLoop *loop;
+	gint64 residual;
+	gint64 residual_min = 0;
+	gint64 residual_max = 0;
+	char info[128];
+	int tolerant_handle;
+	int tick_handle;
+	int k;
+	int i;
+
+	condition.cond_op = CONDITION_EQUAL;
+	condition.cond_value1 = TICK_INTERVAL;
+	fast_condition.cond_op = CONDITION_EQUAL;
+	fast_condition.cond_value1 = 30;
+
+	/* a tolerant subscription leaves its cb slot to the next registration */
+	tolerant_handle = sf_connect(ACCELEROMETER_SENSOR);
+	if (tolerant_handle < 0 ||
+		sf_register_event(tolerant_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, &condition, my_callback_func, NULL) < 0 ||
+		sf_set_event_tolerance(tolerant_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, TICK_INTERVAL / 2) < 0) {
+		tet_infoline("cannot set up a tolerant event");
+		tet_result(TET_FAIL);
+		sf_disconnect(tolerant_handle);
+		return;
+	}
+	sf_disconnect(tolerant_handle);
+
+	/* a faster stream always has a tick within the old tolerance to join */
+	tick_handle = sf_connect(ACCELEROMETER_SENSOR);
+	if (tick_handle < 0 ||
+		sf_register_event(tick_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, &condition, tick_callback_func, NULL) < 0 ||
+		sf_register_event(tick_handle, ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME, &fast_condition, my_callback_func, NULL) < 0 ||
+		sf_start(tick_handle, 0) < 0) {
+		tet_infoline("cannot start the events");
+		tet_result(TET_FAIL);
+		sf_disconnect(tick_handle);
+		return;
+	}
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_timeout_add(TICK_INTERVAL * 20, quit_loop, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+
+	sf_unregister_event(tick_handle, ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME);
+	sf_unregister_event(tick_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(tick_handle);
+
+	if (tick_num < 10) {
+		snprintf(info, sizeof(info), "only %d ticks in %d ms", tick_num, TICK_INTERVAL * 20);
+		tet_infoline(info);
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	/* ticks keep the phase of the stream, a late one stands out from the others */
+	for (i = 1; i < tick_num; i++) {
+		k = (int)((tick_time[i] - tick_time[0] + TICK_INTERVAL * 500) / (TICK_INTERVAL * 1000));
+		residual = tick_time[i] - tick_time[0] - (gint64)k * TICK_INTERVAL * 1000;
+
+		if (residual < residual_min)
+			residual_min = residual;
+		if (residual > residual_max)
+			residual_max = residual;
+	}
+
+	if (residual_max - residual_min > LATENESS_MAX * 1000) {
+		snprintf(info, sizeof(info), "ticks spread over %lld us around their schedule", (long long)(residual_max - residual_min));
+		tet_infoline(info);
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
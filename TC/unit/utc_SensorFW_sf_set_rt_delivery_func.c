@@ -0,0 +1,147 @@
+#include <tet_api.h>
+#include <glib.h>
+#include <sensor.h>
+
+#define RETUNE_NUM		50
+
+int handle = 0;
+int rt_handle = 0;
+volatile gint rt_callback_num = 0;
+volatile gint rt_callback_late = 0;
+volatile gint rt_unregistered = 0;
+
+void my_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+}
+
+void rt_callback_func(unsigned int event_type, sensor_event_data_t *event , void *data)
+{
+	g_atomic_int_inc(&rt_callback_num);
+	if (g_atomic_int_get(&rt_unregistered))
+		g_atomic_int_inc(&rt_callback_late);
+
+	/* widen the window a teardown from the main thread could land in */
+	g_usleep(2000);
+}
+
+static void startup(void);
+static void cleanup(void);
+
+void (*tet_startup)(void) = startup;
+void (*tet_cleanup)(void) = cleanup;
+
+static void utc_SensorFW_sf_set_rt_delivery_func_01(void);
+static void utc_SensorFW_sf_set_rt_delivery_func_02(void);
+static void utc_SensorFW_sf_set_rt_delivery_func_03(void);
+
+enum {
+	POSITIVE_TC_IDX = 0x01,
+	NEGATIVE_TC_IDX,
+};
+
+struct tet_testlist tet_testlist[] = {
+	{ utc_SensorFW_sf_set_rt_delivery_func_01, POSITIVE_TC_IDX },
+	{ utc_SensorFW_sf_set_rt_delivery_func_02, NEGATIVE_TC_IDX },
+	{ utc_SensorFW_sf_set_rt_delivery_func_03, POSITIVE_TC_IDX },
+	{ NULL, 0},
+};
+
+static void startup(void)
+{
+	handle = sf_connect(ACCELEROMETER_SENSOR);
+	sf_register_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, NULL, my_callback_func, NULL);
+}
+
+static void cleanup(void)
+{
+	sf_unregister_event(handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	sf_disconnect(handle);
+}
+
+/**
+ * @brief Positive test case of sf_set_rt_delivery()
+ */
+static void utc_SensorFW_sf_set_rt_delivery_func_01(void)
+{
+	int r = 0;
+
+	r = sf_set_rt_delivery(handle, 10, -1);
+
+	if (r < 0) {
+		tet_infoline("sf_set_rt_delivery() failed in positive test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief Negative test case of ug_init sf_set_rt_delivery()
+ */
+static void utc_SensorFW_sf_set_rt_delivery_func_02(void)
+{
+	int r = 0;
+
+	r = sf_set_rt_delivery(handle, 100, -1);
+
+	if (r >= 0) {
+		tet_infoline("sf_set_rt_delivery() failed in negative test case");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
+
+/**
+ * @brief No callback of the real-time thread runs once sf_unregister_event() returned, while the main thread keeps changing the event
+ */
+static void utc_SensorFW_sf_set_rt_delivery_func_03(void)
+{
+	event_condition_t condition;
+	int i;
+
+	condition.cond_op = CONDITION_EQUAL;
+	condition.cond_value1 = 10;
+
+	rt_handle = sf_connect(ACCELEROMETER_SENSOR);
+	if (rt_handle < 0 ||
+		sf_register_event(rt_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, &condition, rt_callback_func, NULL) < 0 ||
+		sf_set_rt_delivery(rt_handle, 10, -1) < 0 ||
+		sf_start(rt_handle, 0) < 0) {
+		tet_infoline("cannot start a real-time event");
+		tet_result(TET_FAIL);
+		sf_disconnect(rt_handle);
+		return;
+	}
+
+	/* the queue is reallocated under the thread on every call */
+	for (i = 0; i < RETUNE_NUM; i++) {
+		if (sf_set_event_queue(rt_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, (i % 4) + 1, i % 2 ? SENSOR_QUEUE_COALESCE : SENSOR_QUEUE_DROP_OLDEST) < 0) {
+			tet_infoline("sf_set_event_queue() failed on a real-time event");
+			tet_result(TET_FAIL);
+			sf_disconnect(rt_handle);
+			return;
+		}
+		g_usleep(10000);
+	}
+
+	sf_unregister_event(rt_handle, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME);
+	g_atomic_int_set(&rt_unregistered, 1);
+	sf_disconnect(rt_handle);
+
+	/* long enough for several report ticks of the thread */
+	g_usleep(200000);
+
+	if (!g_atomic_int_get(&rt_callback_num)) {
+		tet_infoline("the real-time thread did not call back");
+		tet_result(TET_FAIL);
+		return;
+	}
+
+	if (g_atomic_int_get(&rt_callback_late)) {
+		tet_infoline("a callback ran after sf_unregister_event() returned");
+		tet_result(TET_FAIL);
+		return;
+	}
+	tet_result(TET_PASS);
+}
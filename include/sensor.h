@@ -104,6 +104,9 @@ typedef struct {
 } sensor_event_data_t;
 
 typedef void (*sensor_callback_func_t)(unsigned int, sensor_event_data_t *, void *);  /**/
+typedef void (*sensor_connect_cb_t)(int handle, void *user_data);
+
+struct _GMainContext;		/*GMainContext of glib, for sf_set_main_context()*/
 
 enum sensor_data_unit_idx {
 	SENSOR_UNDEFINED_UNIT,
@@ -129,8 +132,40 @@ enum sensor_data_accuracy {
 enum sensor_start_option {
 	SENSOR_OPTION_DEFAULT = 0,
 	SENSOR_OPTION_ALWAYS_ON = 1,
+	SENSOR_OPTION_BUFFER_LCD_OFF = 2,
+};
+
+enum sensor_event_priority {
+	SENSOR_PRIORITY_DEFAULT = 0,
+	SENSOR_PRIORITY_HIGH = 1,
+	SENSOR_PRIORITY_LOW = 2,
+};
+
+enum sensor_queue_policy {
+	SENSOR_QUEUE_DROP_OLDEST = 0,
+	SENSOR_QUEUE_DROP_NEWEST = 1,
+	SENSOR_QUEUE_COALESCE = 2,
+	SENSOR_QUEUE_BLOCK = 3,
 };
 
+typedef struct {
+	unsigned int delivered;
+	unsigned int dropped;
+	unsigned int coalesced;
+	unsigned int blocked;
+	unsigned int queued;
+	unsigned int max_queued;
+} sensor_event_stats_t;
+
+typedef struct {
+	unsigned int wakeups;
+	unsigned int wakeups_saved;
+	unsigned int io_dropped;
+	unsigned int rt_ticks;
+	unsigned int rt_jitter_avg_us;
+	unsigned int rt_jitter_max_us;
+} sensor_lib_stats_t;
+
 typedef struct {
 	int data_accuracy;
 	int data_unit_idx;
@@ -210,7 +245,7 @@ int sf_connect(sensor_type_t sensor_type);
 
 /**
  * @fn int sf_disconnect(int handle)
- * @brief This API disconnects an attached sensor from an application. Application must use the handle retuned after attaching the sensor. After detaching, the corresponding handle will be released.
+ * @brief This API disconnects an attached sensor from an application. Application must use the handle retuned after attaching the sensor. After detaching, the corresponding handle will be released and every later call with it fails, even once its slot is reused by another sf_connect().
  * @param[in] handle received handle value by sf_connect()
  * @return if it succeed, it return zero value , otherwise negative value return
  */
@@ -221,7 +256,7 @@ int sf_disconnect(int handle);
  * @fn int sf_start(int handle , int option)
  * @brief This API sends a start command to sensor server. This intimates server that the client side is ready to handle data and start processing. The parameter option should be '0' for current usages.
  * @param[in] handle received handle value by sf_connect()
- * @param[in] option With SENSOR_OPTION_DEFAULT, it stops to sense when LCD is off, and with SENSOR_OPTION_ALWAYS_ON, it continues to sense even when LCD is off
+ * @param[in] option With SENSOR_OPTION_DEFAULT, it stops to sense when LCD is off, and with SENSOR_OPTION_ALWAYS_ON, it continues to sense even when LCD is off. With SENSOR_OPTION_BUFFER_LCD_OFF, report on time events keep sampling into their queue (see sf_set_event_queue()) while LCD is off, and the queued samples are passed to the callback as one array of sensor_data_t when LCD turns on
  * @return if it succeed, it return zero value , otherwise negative value return
  */
 int sf_start(int handle , int option);
@@ -235,6 +270,62 @@ int sf_start(int handle , int option);
  */
 int sf_stop(int handle);
 
+
+/**
+ * @fn int sf_create_group(void)
+ * @brief This API creates an empty sensor group. Handles added to a group are started and stopped together by sf_group_start() and sf_group_stop(), and the report timers of their events are aligned to the same start time.
+ * @return if it succeed, it return group value( >=0 ) , otherwise negative value return
+ */
+int sf_create_group(void);
+
+
+/**
+ * @fn int sf_destroy_group(int group)
+ * @brief This API destroys a sensor group. The handles of the group are neither stopped nor disconnected.
+ * @param[in] group received group value by sf_create_group()
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_destroy_group(int group);
+
+
+/**
+ * @fn int sf_group_add(int group, int handle)
+ * @brief This API adds a connected sensor to a sensor group. A disconnected handle leaves its groups automatically.
+ * @param[in] group received group value by sf_create_group()
+ * @param[in] handle received handle value by sf_connect()
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_group_add(int group, int handle);
+
+
+/**
+ * @fn int sf_group_remove(int group, int handle)
+ * @brief This API removes a sensor from a sensor group.
+ * @param[in] group received group value by sf_create_group()
+ * @param[in] handle received handle value by sf_connect()
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_group_remove(int group, int handle);
+
+
+/**
+ * @fn int sf_group_start(int group, int option)
+ * @brief This API starts every sensor of a group. The start commands are sent to all sensors before any reply is awaited, and if one of them fails the others are stopped again. On success the report timers of all events registered on the group are restarted from the same instant, so events with related intervals fire together.
+ * @param[in] group received group value by sf_create_group()
+ * @param[in] option same as the option of sf_start()
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_group_start(int group, int option);
+
+
+/**
+ * @fn int sf_group_stop(int group)
+ * @brief This API stops every sensor of a group.
+ * @param[in] group received group value by sf_create_group()
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_group_stop(int group);
+
 /**
  * @fn int sf_register_event(int handle , unsigned int event_type , event_conditon_t *event_condition , sensor_callback_func_t cb , void *cb_data )
  * @brief This API registers a user defined callback function with a connected sensor for a particular event. This callback function will be called when there is a change in the state of respective sensor. cb_data will be the parameter used during the callback call. Callback interval can be adjusted using even_contion_t argument.
@@ -248,6 +339,19 @@ int sf_stop(int handle);
 int sf_register_event(int handle , unsigned int event_type , event_condition_t *event_condition , sensor_callback_func_t cb , void *cb_data );
 
 
+/**
+ * @fn int sf_register_events(int handle , unsigned int event_mask , event_condition_t *event_conditions[] , sensor_callback_func_t cb , void *cb_data )
+ * @brief This API registers one callback function for several events of a connected sensor at once. event_mask is built by OR-ing event types of the same sensor (ex. ACCELEROMETER_EVENT_ROTATION_CHECK | ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME), and every request is sent to the server in a single exchange. The callback receives the single event type that fired as its first argument. If any event cannot be registered, none of them stays registered.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_mask OR-ed event types of the sensor connected with handle
+ * @param[in] event_conditions array of event_condition pointers, one per bit set in event_mask from the lowest bit up. Both the array and its entries may be NULL
+ * @param[in] cb your define callback function
+ * @param[in] cb_data	your option data that will be send when your define callback function called. if you don't have any option data, just use a NULL value
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_register_events(int handle , unsigned int event_mask , event_condition_t *event_conditions[] , sensor_callback_func_t cb , void *cb_data );
+
+
 /**
  * @fn int sf_unregister_event(int handle, unsigned int event_type)
  * @brief This API de-registers a user defined callback function with a sensor registered with the specified handle. After unsubscribe, no event will be sent to the application. 
@@ -258,6 +362,16 @@ int sf_register_event(int handle , unsigned int event_type , event_condition_t *
 int sf_unregister_event(int handle, unsigned int event_type);
 
 
+/**
+ * @fn int sf_unregister_events(int handle, unsigned int event_mask)
+ * @brief This API de-registers every registered event in event_mask with a single exchange with the server. Bits of event_mask without a registered callback are ignored.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_mask OR-ed event types that you want to unregister
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_unregister_events(int handle, unsigned int event_mask);
+
+
 /**
  * @fn int sf_get_data(int handle , unsigned int data_id , sensor_data_t* values)
  * @brief This API gets raw data from a sensor with connecting the sensor-server. The type of sensor is supplied and return data is stored in the output parameter values [].
@@ -314,13 +428,181 @@ int sf_is_wakeup_enabled(sensor_type_t sensor_type);
 
 /**
  * @fn int sf_change_event_condition(int handle, unsigned int event_type, event_condition_t *event_condition)
- * @brief This API change a user defined callback function condition with a sensor registered with the specified handle.
+ * @brief This API change a user defined callback function condition with a sensor registered with the specified handle. The new interval applies from the next tick without stopping the stream, and a rejection by the server is only logged.
  * @param[in] handle received handle value by sf_connect()
  * @param[in] event_type your desired event_type that you want to unregister event
  * @param[in] event_condition your desired event condition that you want to change event
  * @return if it succeed, it return zero value , otherwise negative value return
  */
 int sf_change_event_condition(int handle, unsigned int event_type, event_condition_t *event_condition);
+
+
+/**
+ * @fn int sf_set_event_queue(int handle, unsigned int event_type, unsigned int depth, int policy)
+ * @brief This API sets the size of the sample queue between the report timer of a registered *_REPORT_ON_TIME event and its callback function, and what happens when the callback cannot keep up. With SENSOR_QUEUE_DROP_OLDEST the oldest queued sample is replaced, with SENSOR_QUEUE_DROP_NEWEST the new sample is discarded, with SENSOR_QUEUE_COALESCE the newest queued sample is overwritten, and with SENSOR_QUEUE_BLOCK no new sample is read from the sensor until the queue has room. The default is a queue of one sample with SENSOR_QUEUE_DROP_OLDEST. Samples still queued are discarded.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[in] depth number of samples the queue can hold (1 ~ 256)
+ * @param[in] policy enum sensor_queue_policy value
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_event_queue(int handle, unsigned int event_type, unsigned int depth, int policy);
+
+
+/**
+ * @fn int sf_get_event_stats(int handle, unsigned int event_type, sensor_event_stats_t *stats)
+ * @brief This API gets the delivery counters of a registered *_REPORT_ON_TIME event : delivered, dropped and coalesced samples, report ticks held back by SENSOR_QUEUE_BLOCK, and the current and highest queue length.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[out] stats delivery counters of the event
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_get_event_stats(int handle, unsigned int event_type, sensor_event_stats_t *stats);
+
+
+/**
+ * @fn int sf_set_event_priority(int handle, unsigned int event_type, int priority)
+ * @brief This API sets the priority class of a registered *_REPORT_ON_TIME event. When the main loop is busy, callbacks of SENSOR_PRIORITY_HIGH events are called before those of SENSOR_PRIORITY_DEFAULT events, which are called before those of SENSOR_PRIORITY_LOW events. The classes map to G_PRIORITY_HIGH, G_PRIORITY_DEFAULT and G_PRIORITY_LOW of glib. sf_register_event() puts an event in SENSOR_PRIORITY_DEFAULT, it stays there until this API is called, and samples queued before the call move to the new class.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[in] priority enum sensor_event_priority value
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_event_priority(int handle, unsigned int event_type, int priority);
+
+
+/**
+ * @fn int sf_set_event_batch(int handle, unsigned int event_type, unsigned int max_latency)
+ * @brief This API sets the max report latency of a registered *_REPORT_ON_TIME event. Samples are still taken at the event interval, but they are passed to the callback as one array of sensor_data_t, oldest first, at most max_latency ms after the first of them was taken. The event queue grows to hold a whole batch, up to 256 samples. A max_latency of 0 delivers every sample on its own again.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[in] max_latency max report latency in ms
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_event_batch(int handle, unsigned int event_type, unsigned int max_latency);
+
+
+/**
+ * @fn int sf_set_event_adaptive(int handle, unsigned int event_type, unsigned int max_interval, float threshold)
+ * @brief This API turns on adaptive sampling of a registered *_REPORT_ON_TIME event. While the first three values of consecutive samples stay within threshold, the interval doubles every 10 samples up to max_interval, and the first sample beyond threshold brings back the interval set at registration or by sf_change_event_condition(). The server is told of each change from the default glib main loop, whichever loop or thread serves the event. A max_interval of 0 turns adaptive sampling off.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[in] max_interval slowest interval in ms, not below the event interval
+ * @param[in] threshold largest change of a value still counted as idle, in the unit of the event data
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_event_adaptive(int handle, unsigned int event_type, unsigned int max_interval, float threshold);
+
+
+/**
+ * @fn int sf_set_event_tolerance(int handle, unsigned int event_type, unsigned int tolerance)
+ * @brief This API lets samples of a registered *_REPORT_ON_TIME event be taken up to tolerance ms late, so that the library serves several events in one wakeup. A sensor stream uses the smallest tolerance of its events, and at most half of its interval. The default tolerance is 0.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[in] tolerance allowed lateness in ms
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_event_tolerance(int handle, unsigned int event_type, unsigned int tolerance);
+
+
+/**
+ * @fn int sf_get_lib_stats(sensor_lib_stats_t *stats)
+ * @brief This API reads counters of the whole library. wakeups counts timer wakeups that served at least one sensor stream, and wakeups_saved counts the streams served by a wakeup another stream had already paid for. io_dropped counts samples of the I/O thread lost because their main loop was too far behind. rt_ticks counts the ticks of the real-time thread, and rt_jitter_avg_us and rt_jitter_max_us give how late they were served in microseconds.
+ * @param[out] stats library counters
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_get_lib_stats(sensor_lib_stats_t *stats);
+
+
+/**
+ * @fn int sf_connect_async(sensor_type_t sensor_type, sensor_connect_cb_t cb, void *user_data)
+ * @brief This API connects to a sensor like sf_connect() without blocking the caller. The connection and the hello exchange with the server run on a library thread, and cb is called from the default glib main loop with the handle, or with the negative value sf_connect() would have returned and errno set. Several sensors can be connected at the same time.
+ * @param[in] sensor_type your desired sensor type
+ * @param[in] cb function called with the result of the connection
+ * @param[in] user_data data passed to cb
+ * @return if the connection is started, it return zero value , otherwise negative value return
+ */
+int sf_connect_async(sensor_type_t sensor_type, sensor_connect_cb_t cb, void *user_data);
+
+
+/**
+ * @fn int sf_get_event_fd(void)
+ * @brief This API returns a file descriptor that becomes readable when *_REPORT_ON_TIME events of the process are due or waiting for their callback, so that an application without a glib main loop can watch it with poll or epoll and call sf_dispatch_pending() when it is readable. The descriptor belongs to the library and must not be closed. It covers the handles left on the default context by sf_set_main_context(), and other events are still notified through the default glib main loop.
+ * @return if it succeed, it return the file descriptor ( >=0 ) , otherwise negative value return
+ */
+int sf_get_event_fd(void);
+
+
+/**
+ * @fn int sf_dispatch_pending(int max)
+ * @brief This API takes the samples of due *_REPORT_ON_TIME events and calls the callbacks of at most max waiting samples, SENSOR_PRIORITY_HIGH events first. It never blocks. When samples are left, the descriptor of sf_get_event_fd() stays readable. It must be called from one thread, and not along with a running default glib main loop.
+ * @param[in] max largest number of callbacks to call, 0 or less for all of them
+ * @return if it succeed, it return the number of callbacks called , otherwise negative value return
+ */
+int sf_dispatch_pending(int max);
+
+
+/**
+ * @fn int sf_set_main_context(int handle, struct _GMainContext *context)
+ * @brief This API chooses the glib main context that samples the *_REPORT_ON_TIME events of a handle and calls their callbacks, so that a busy sensor can be served by the main loop of a worker thread instead of the default one. Events already registered move to the new context with their waiting samples. A NULL context is the default one. The library keeps a reference on the context while a handle uses it, and serves up to 3 contexts besides the default one. Other events are still notified through the default glib main loop.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] context GMainContext to serve the handle, or NULL
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_main_context(int handle, struct _GMainContext *context);
+
+
+/**
+ * @fn int sf_set_io_thread(int enable)
+ * @brief This API moves the sampling of *_REPORT_ON_TIME events to a thread of the library. The thread takes the samples on time over connections of its own, time stamps them on arrival and hands them to the main loop of their handle, which calls the callbacks as before : a busy main loop no longer delays sampling. A connection of the thread is opened for each handle while it is started, by the call that starts it or moves it to the thread. Up to 64 samples per main loop wait for it, later ones are counted in io_dropped of sf_get_lib_stats(). It must be called while no *_REPORT_ON_TIME event is running, from the thread making the other calls.
+ * @param[in] enable 1 to start the thread, 0 to stop it
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_io_thread(int enable);
+
+
+/**
+ * @fn int sf_set_rt_delivery(int handle, int priority, int cpu)
+ * @brief This API serves the *_REPORT_ON_TIME events of a handle from a real-time thread of the library, running with SCHED_FIFO priority, on cpu when it is not negative, and with its stack and tables locked in memory. The thread takes the samples on a connection of its own and calls the callbacks itself, outside of any glib main loop. Handles share one thread, and the last call sets its priority and cpu. Without the privilege for SCHED_FIFO the thread keeps the normal scheduling. Calls made from other threads on any handle wait for the round of callbacks in progress, so no callback of an event runs once sf_unregister_event() or sf_disconnect() returned. sf_set_main_context() brings a handle back to a main loop. The lateness of the ticks is reported by sf_get_lib_stats().
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] priority SCHED_FIFO priority, from 1 to 99
+ * @param[in] cpu cpu the thread runs on, or -1 for any
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_rt_delivery(int handle, int priority, int cpu);
+
+
+/**
+ * @fn int sf_set_event_executor(int handle, unsigned int event_type, int enable)
+ * @brief This API hands the samples of a registered *_REPORT_ON_TIME event over to a pool of worker threads of the library, one per online cpu up to 8, so that callbacks doing heavy processing run in parallel instead of one after another on the main loop. The callbacks of one event are called one at a time and in order, while the callbacks of different events run on different cores. A callback called by the pool must not call the library API. The pool holds the newest 16 samples of each event, older ones are counted as dropped. Disabling drops the samples still held and waits for a running callback to return. Batched events keep their callback on the main loop.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type
+ * @param[in] enable non-zero value to use the pool, zero to call back from the main loop again
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_set_event_executor(int handle, unsigned int event_type, int enable);
+
+
+/**
+ * @fn int sf_record_start(int handle, unsigned int event_type, const char *path)
+ * @brief This API records the samples delivered to a registered *_REPORT_ON_TIME event of a handle, or to all of them when event_type is zero, into the file at path. The file is mapped in memory and grows by chunks of the format of sensor_record.h, one data_id per chunk with its values in columns, so recording adds no system call per sample. Events registered later are not recorded. The file is closed by sf_record_stop(), sf_unregister_event() or sf_disconnect().
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type registered *_REPORT_ON_TIME event type, or zero for every one of the handle
+ * @param[in] path file to create, an existing one is truncated
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_record_start(int handle, unsigned int event_type, const char *path);
+
+
+/**
+ * @fn int sf_record_stop(int handle, unsigned int event_type)
+ * @brief This API stops recording a *_REPORT_ON_TIME event of a handle, or all of them when event_type is zero. The record file is closed when none of its events is recorded anymore.
+ * @param[in] handle received handle value by sf_connect()
+ * @param[in] event_type recorded *_REPORT_ON_TIME event type, or zero for every one of the handle
+ * @return if it succeed, it return zero value , otherwise negative value return
+ */
+int sf_record_stop(int handle, unsigned int event_type);
+
 /**
   * @}
  */
@@ -0,0 +1,114 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#ifndef __SAMSUNG_LINUX_SENSOR_RECORD_H__
+#define __SAMSUNG_LINUX_SENSOR_RECORD_H__
+
+/*
+ * File written by sf_record_start(), to be read through mmap().
+ *
+ * The file is a sequence of SENSOR_RECORD_CHUNK_SIZE byte chunks. Chunk 0 holds
+ * sensor_record_header_t, every other chunk the samples of one data_id in columns :
+ *
+ *	sensor_record_chunk_t
+ *	unsigned long long time_stamp[sample_max]
+ *	float values[values_num][sample_max]
+ *	signed char accuracy[sample_max]
+ *
+ * Chunks are appended in the order of their first_ts, and the chunks of one data_id
+ * do not overlap in time, so the chunk headers are a sparse time index :
+ * sensor_record_seek() finds a chunk by time_stamp with a binary search.
+ * chunk_num and sample_num grow while the file is recorded.
+ */
+
+#define SENSOR_RECORD_MAGIC			"SFREC01"
+#define SENSOR_RECORD_VERSION		1
+#define SENSOR_RECORD_CHUNK_SIZE	4096
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct {
+	char magic[8];
+	unsigned int version;
+	unsigned int chunk_size;
+	unsigned int chunk_num;					/*chunks in the file, this one included*/
+	unsigned int reserved;
+} sensor_record_header_t;
+
+typedef struct {
+	unsigned int data_id;
+	unsigned int sample_num;
+	unsigned int sample_max;
+	unsigned short values_num;
+	short data_unit_idx;
+	unsigned long long first_ts;
+	unsigned long long last_ts;
+} sensor_record_chunk_t;
+
+#define SENSOR_RECORD_CHUNK(map, idx) \
+	((sensor_record_chunk_t *)((char *)(map) + (unsigned long)(idx) * SENSOR_RECORD_CHUNK_SIZE))
+
+#define SENSOR_RECORD_TIME_STAMPS(chunk) \
+	((unsigned long long *)((char *)(chunk) + sizeof(sensor_record_chunk_t)))
+
+#define SENSOR_RECORD_VALUES(chunk, v) \
+	((float *)((char *)SENSOR_RECORD_TIME_STAMPS(chunk) + \
+		(sizeof(unsigned long long) + sizeof(float) * (v)) * (chunk)->sample_max))
+
+#define SENSOR_RECORD_ACCURACY(chunk) \
+	((signed char *)SENSOR_RECORD_VALUES(chunk, (chunk)->values_num))
+
+/**
+ * @fn static inline unsigned int sensor_record_seek(const void *map, unsigned long long time_stamp)
+ * @brief This function finds the last chunk starting at or before time_stamp in a mapped record file. The chunk of a given data_id holding time_stamp is this one or one of the chunks before it.
+ * @param[in] map record file mapped in memory
+ * @param[in] time_stamp time_stamp of sensor_data_t to look for
+ * @return index of the chunk, or zero when the file has no sample up to time_stamp
+ */
+static inline unsigned int sensor_record_seek(const void *map, unsigned long long time_stamp)
+{
+	const sensor_record_header_t *header = (const sensor_record_header_t *)map;
+	unsigned int low = 1;
+	unsigned int high = header->chunk_num;
+	unsigned int mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (SENSOR_RECORD_CHUNK(map, mid)->first_ts <= time_stamp)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low - 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+//! End of a file
@@ -0,0 +1,276 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#ifndef __SAMSUNG_LINUX_SENSOR_STREAM_H__
+#define __SAMSUNG_LINUX_SENSOR_STREAM_H__
+
+/*
+ * Header only C++20 coroutine layer over sf_connect() and sf_register_event() :
+ *
+ *	sensor::task consume(sensor::stream &accel)
+ *	{
+ *		for (;;) {
+ *			sensor_data_t sample = co_await accel.next();
+ *			...
+ *		}
+ *	}
+ *
+ *	sensor::stream accel(ACCELEROMETER_SENSOR, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, 20);
+ *	consume(accel);
+ *
+ * Samples arriving while no coroutine waits stay in a ring of Capacity samples,
+ * the oldest is dropped when it is full. Awaiters live in the coroutine frame and
+ * the ring in the stream, so an await allocates nothing.
+ * The waiting coroutine is handed to Executor::post() from the callback of the library,
+ * inline_executor resumes it right there, on the thread delivering the samples.
+ * A stream must outlive the coroutines waiting on it.
+ */
+
+#if defined(__cplusplus) && (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <cstddef>
+#include <cerrno>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <system_error>
+
+#include <sensor.h>
+
+namespace sensor {
+
+//! Resumes the waiting coroutine in the callback of the library
+struct inline_executor {
+	void post(std::coroutine_handle<> coroutine) { coroutine.resume(); }
+};
+
+template <typename E>
+concept executor = requires(E &e, std::coroutine_handle<> coroutine) { e.post(coroutine); };
+
+//! Coroutine type for pipelines, started at once and freed when it returns
+struct task {
+	struct promise_type {
+		task get_return_object(void) noexcept { return task(); }
+		std::suspend_never initial_suspend(void) noexcept { return {}; }
+		std::suspend_never final_suspend(void) noexcept { return {}; }
+		void return_void(void) noexcept {}
+		void unhandled_exception(void) noexcept { std::terminate(); }
+	};
+};
+
+template <executor Executor = inline_executor, std::size_t Capacity = 16>
+class basic_stream {
+public:
+	//! interval_ms 0 keeps the default interval, max_latency_ms batches samples with sf_set_event_batch()
+	basic_stream(sensor_type_t sensor_type, unsigned int event_type, unsigned int interval_ms,
+		unsigned int max_latency_ms = 0, Executor ex = Executor())
+	: m_handle(-1)
+	, m_event_type(event_type)
+	, m_executor(ex)
+	, m_head(0)
+	, m_num(0)
+	, m_dropped(0)
+	, m_waiter(nullptr)
+	, m_want()
+	, m_got(nullptr)
+	{
+		event_condition_t condition;
+
+		condition.cond_op = CONDITION_EQUAL;
+		condition.cond_value1 = (float)interval_ms;
+
+		m_handle = sf_connect(sensor_type);
+		if (m_handle < 0)
+			throw std::system_error(errno, std::generic_category(), "sf_connect");
+
+		if (sf_register_event(m_handle, event_type, interval_ms ? &condition : nullptr, on_event, this) < 0)
+			fail("sf_register_event");
+
+		if (max_latency_ms && sf_set_event_batch(m_handle, event_type, max_latency_ms) < 0)
+			fail("sf_set_event_batch");
+
+		if (sf_start(m_handle, 0) < 0)
+			fail("sf_start");
+	}
+
+	~basic_stream()
+	{
+		sf_stop(m_handle);
+		sf_unregister_event(m_handle, m_event_type);
+		sf_disconnect(m_handle);
+	}
+
+	basic_stream(const basic_stream &) = delete;
+	basic_stream &operator=(const basic_stream &) = delete;
+
+	//! co_await gives one sample
+	class next_awaiter {
+	public:
+		explicit next_awaiter(basic_stream &stream) : m_stream(stream), m_num(0) {}
+
+		bool await_ready(void) { return m_stream.take(std::span<sensor_data_t>(&m_sample, 1), m_num); }
+		bool await_suspend(std::coroutine_handle<> coroutine) { return m_stream.wait(coroutine, std::span<sensor_data_t>(&m_sample, 1), m_num); }
+		sensor_data_t await_resume(void) { return m_sample; }
+
+	private:
+		basic_stream &m_stream;
+		sensor_data_t m_sample;
+		std::size_t m_num;
+	};
+
+	//! co_await fills out with at least one sample and gives how many
+	class batch_awaiter {
+	public:
+		batch_awaiter(basic_stream &stream, std::span<sensor_data_t> out) : m_stream(stream), m_out(out), m_num(0) {}
+
+		bool await_ready(void) { return m_out.empty() || m_stream.take(m_out, m_num); }
+		bool await_suspend(std::coroutine_handle<> coroutine) { return m_stream.wait(coroutine, m_out, m_num); }
+		std::size_t await_resume(void) { return m_num; }
+
+	private:
+		basic_stream &m_stream;
+		std::span<sensor_data_t> m_out;
+		std::size_t m_num;
+	};
+
+	next_awaiter next(void) { return next_awaiter(*this); }
+	batch_awaiter next_batch(std::span<sensor_data_t> out) { return batch_awaiter(*this, out); }
+
+	int handle(void) const { return m_handle; }
+
+	unsigned int dropped(void)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		return m_dropped;
+	}
+
+private:
+	int m_handle;
+	unsigned int m_event_type;
+	[[no_unique_address]] Executor m_executor;
+
+	std::mutex m_lock;
+	sensor_data_t m_ring[Capacity];
+	std::size_t m_head;
+	std::size_t m_num;
+	unsigned int m_dropped;
+
+	/* the one coroutine waiting, and where its samples go */
+	std::coroutine_handle<> m_waiter;
+	std::span<sensor_data_t> m_want;
+	std::size_t *m_got;
+
+	[[noreturn]] void fail(const char *what)
+	{
+		const int error = errno;
+
+		sf_unregister_event(m_handle, m_event_type);
+		sf_disconnect(m_handle);
+		throw std::system_error(error, std::generic_category(), what);
+	}
+
+	std::size_t pop(std::span<sensor_data_t> out)
+	{
+		std::size_t i;
+
+		for (i = 0; i < out.size() && m_num; i++) {
+			out[i] = m_ring[m_head];
+			m_head = (m_head + 1) % Capacity;
+			m_num--;
+		}
+
+		return i;
+	}
+
+	void push(const sensor_data_t &sample)
+	{
+		if (m_num == Capacity) {
+			m_head = (m_head + 1) % Capacity;
+			m_num--;
+			m_dropped++;
+		}
+
+		m_ring[(m_head + m_num) % Capacity] = sample;
+		m_num++;
+	}
+
+	bool take(std::span<sensor_data_t> out, std::size_t &num)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+
+		num = pop(out);
+		return num > 0;
+	}
+
+	/* false resumes at once, a sample came in since await_ready() */
+	bool wait(std::coroutine_handle<> coroutine, std::span<sensor_data_t> out, std::size_t &num)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+
+		num = pop(out);
+		if (num)
+			return false;
+
+		m_waiter = coroutine;
+		m_want = out;
+		m_got = &num;
+		return true;
+	}
+
+	static void on_event(unsigned int, sensor_event_data_t *event, void *data)
+	{
+		basic_stream *stream = static_cast<basic_stream *>(data);
+		const sensor_data_t *samples = static_cast<const sensor_data_t *>(event->event_data);
+		const std::size_t sample_num = event->event_data_size / sizeof(sensor_data_t);
+		std::coroutine_handle<> waiter = nullptr;
+		std::size_t i;
+
+		{
+			std::lock_guard<std::mutex> guard(stream->m_lock);
+
+			for (i = 0; i < sample_num; i++) {
+				if (stream->m_waiter && *stream->m_got < stream->m_want.size())
+					stream->m_want[(*stream->m_got)++] = samples[i];
+				else
+					stream->push(samples[i]);
+			}
+
+			if (stream->m_waiter && *stream->m_got) {
+				waiter = stream->m_waiter;
+				stream->m_waiter = nullptr;
+			}
+		}
+
+		if (waiter)
+			stream->m_executor.post(waiter);
+	}
+};
+
+typedef basic_stream<> stream;
+
+}
+
+#endif
+#endif
+//! End of a file
@@ -0,0 +1,316 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#ifndef __SAMSUNG_LINUX_SENSOR_TYPED_H__
+#define __SAMSUNG_LINUX_SENSOR_TYPED_H__
+
+/*
+ * Header only typed C++17 layer over sensor.h :
+ *
+ *	sensor::device<sensor::Accelerometer> accel;
+ *	auto raw = accel.subscribe<sensor::Accelerometer::Raw>(20, [](const sensor::sample<3> &s) {
+ *		... s.values[0], s.values[1], s.values[2] ...
+ *	});
+ *	accel.start();
+ *
+ * Each sensor is a tag type, and each of its events a nested tag carrying
+ * its event_type, its data_id and the type its callback receives, all constexpr.
+ * Subscribing to the event of another sensor, or asking an interval or a
+ * sf_get_data() of an event that is not *_REPORT_ON_TIME, does not compile.
+ * The trampoline given to sf_register_event() is generated per event,
+ * so the sample is converted with a fixed size copy and no switch on event_type.
+ * device and subscription release their handle and event when destroyed,
+ * and failures throw std::system_error with the errno of the library.
+ */
+
+#if defined(__cplusplus) && (__cplusplus >= 201703L)
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <sensor.h>
+
+namespace sensor {
+
+//! Sample of a *_REPORT_ON_TIME event with its N values
+template <std::size_t N>
+struct sample {
+	static_assert(N > 0 && N <= MAX_VALUE_SIZE, "a sample holds 1 ~ MAX_VALUE_SIZE values");
+
+	unsigned long long time_stamp;
+	int accuracy;
+	int unit;
+	float values[N];
+
+	static constexpr std::size_t size = N;
+
+	float operator[](std::size_t i) const { return values[i]; }
+};
+
+/*
+ * Event descriptors. Value is what the callback receives :
+ * sample<N> for *_REPORT_ON_TIME events, the int or struct of the vconf key otherwise.
+ */
+template <typename Sensor, unsigned int EventType, unsigned int DataId, typename Value>
+struct event_traits {
+	typedef Sensor sensor;
+	typedef Value value_type;
+
+	static constexpr unsigned int event_type = EventType;
+	static constexpr unsigned int data_id = DataId;
+	static constexpr bool on_time = (DataId != 0);
+};
+
+template <typename Sensor, unsigned int EventType, unsigned int DataId, std::size_t N>
+struct on_time_event : event_traits<Sensor, EventType, DataId, sample<N> > {};
+
+template <typename Sensor, unsigned int EventType, typename Value = int>
+struct state_event : event_traits<Sensor, EventType, 0, Value> {};
+
+struct Accelerometer {
+	static constexpr sensor_type_t type = ACCELEROMETER_SENSOR;
+
+	struct RotationCheck : state_event<Accelerometer, ACCELEROMETER_EVENT_ROTATION_CHECK> {};
+	struct Raw : on_time_event<Accelerometer, ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, ACCELEROMETER_BASE_DATA_SET, 3> {};
+	struct CalibrationNeeded : state_event<Accelerometer, ACCELEROMETER_EVENT_CALIBRATION_NEEDED> {};
+	struct SetHorizon : state_event<Accelerometer, ACCELEROMETER_EVENT_SET_HORIZON> {};
+	struct SetWakeup : state_event<Accelerometer, ACCELEROMETER_EVENT_SET_WAKEUP> {};
+	struct Orientation : on_time_event<Accelerometer, ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME, ACCELEROMETER_ORIENTATION_DATA_SET, 3> {};
+	struct LinearAcceleration : on_time_event<Accelerometer, ACCELEROMETER_EVENT_LINEAR_ACCELERATION_DATA_REPORT_ON_TIME, ACCELEROMETER_LINEAR_ACCELERATION_DATA_SET, 3> {};
+};
+
+struct Geomagnetic {
+	static constexpr sensor_type_t type = GEOMAGNETIC_SENSOR;
+
+	struct CalibrationNeeded : state_event<Geomagnetic, GEOMAGNETIC_EVENT_CALIBRATION_NEEDED> {};
+	struct Raw : on_time_event<Geomagnetic, GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME, GEOMAGNETIC_RAW_DATA_SET, 3> {};
+	struct Attitude : on_time_event<Geomagnetic, GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME, GEOMAGNETIC_ATTITUDE_DATA_SET, 3> {};
+};
+
+struct Light {
+	static constexpr sensor_type_t type = LIGHT_SENSOR;
+
+	struct ChangeLevel : state_event<Light, LIGHT_EVENT_CHANGE_LEVEL> {};
+	struct Level : on_time_event<Light, LIGHT_EVENT_LEVEL_DATA_REPORT_ON_TIME, LIGHT_BASE_DATA_SET, 1> {};
+	struct Lux : on_time_event<Light, LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME, LIGHT_LUX_DATA_SET, 1> {};
+};
+
+struct Proximity {
+	static constexpr sensor_type_t type = PROXIMITY_SENSOR;
+
+	struct ChangeState : state_event<Proximity, PROXIMITY_EVENT_CHANGE_STATE> {};
+	struct State : on_time_event<Proximity, PROXIMITY_EVENT_STATE_REPORT_ON_TIME, PROXIMITY_BASE_DATA_SET, 1> {};
+	struct Distance : on_time_event<Proximity, PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME, PROXIMITY_DISTANCE_DATA_SET, 1> {};
+};
+
+struct Gyroscope {
+	static constexpr sensor_type_t type = GYROSCOPE_SENSOR;
+
+	struct Raw : on_time_event<Gyroscope, GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME, GYRO_BASE_DATA_SET, 3> {};
+};
+
+struct Barometer {
+	static constexpr sensor_type_t type = BAROMETER_SENSOR;
+
+	struct Raw : on_time_event<Barometer, BAROMETER_EVENT_RAW_DATA_REPORT_ON_TIME, BAROMETER_BASE_DATA_SET, 1> {};
+	struct Temperature : on_time_event<Barometer, BAROMETER_EVENT_TEMPERATURE_DATA_REPORT_ON_TIME, BAROMETER_TEMPERATURE_DATA_SET, 1> {};
+	struct Altitude : on_time_event<Barometer, BAROMETER_EVENT_ALTITUDE_DATA_REPORT_ON_TIME, BAROMETER_ALTITUDE_DATA_SET, 1> {};
+};
+
+struct Motion {
+	static constexpr sensor_type_t type = MOTION_SENSOR;
+
+	struct Snap : state_event<Motion, MOTION_ENGINE_EVENT_SNAP> {};
+	struct Shake : state_event<Motion, MOTION_ENGINE_EVENT_SHAKE> {};
+	struct DoubleTap : state_event<Motion, MOTION_ENGINE_EVENT_DOUBLETAP> {};
+	struct Panning : state_event<Motion, MOTION_ENGINE_EVENT_PANNING, sensor_panning_data_t> {};
+	struct TopToBottom : state_event<Motion, MOTION_ENGINE_EVENT_TOP_TO_BOTTOM> {};
+	struct DirectCall : state_event<Motion, MOTION_ENGINE_EVENT_DIRECT_CALL> {};
+	struct TiltToUnlock : state_event<Motion, MOTION_ENGINE_EVENT_TILT_TO_UNLOCK> {};
+	struct LockExecuteCamera : state_event<Motion, MOTION_ENGINE_EVENT_LOCK_EXECUTE_CAMERA> {};
+	struct ReactiveAlert : state_event<Motion, MOTION_ENGINE_EVENT_REACTIVE_ALERT> {};
+};
+
+struct Fusion {
+	static constexpr sensor_type_t type = FUSION_SENSOR;
+
+	struct Raw : on_time_event<Fusion, FUSION_SENSOR_EVENT_RAW_DATA_REPORT_ON_TIME, FUSION_BASE_DATA_SET, 3> {};
+	struct RotationVector : on_time_event<Fusion, FUSION_ROTATION_VECTOR_EVENT_DATA_REPORT_ON_TIME, FUSION_ROTATION_VECTOR_DATA_SET, 4> {};
+	struct RotationMatrix : on_time_event<Fusion, FUSION_ROTATION_MATRIX_EVENT_DATA_REPORT_ON_TIME, FUSION_ROTATION_MATRIX_DATA_SET, 9> {};
+};
+
+namespace detail {
+
+[[noreturn]] inline void throw_errno(const char *what)
+{
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+template <std::size_t N>
+inline void to_sample(const sensor_data_t &data, sample<N> &out)
+{
+	out.time_stamp = data.time_stamp;
+	out.accuracy = data.data_accuracy;
+	out.unit = data.data_unit_idx;
+	std::memcpy(out.values, data.values, sizeof(out.values));
+}
+
+}
+
+//! A registered event, unregistered when destroyed
+template <typename Event, typename F>
+class subscription {
+public:
+	subscription(int handle, unsigned int interval_ms, F &&fn)
+	: m_handle(handle)
+	, m_fn(std::forward<F>(fn))
+	{
+		event_condition_t condition;
+
+		condition.cond_op = CONDITION_EQUAL;
+		condition.cond_value1 = (float)interval_ms;
+
+		if (sf_register_event(m_handle, Event::event_type, interval_ms ? &condition : nullptr, trampoline, this) < 0)
+			detail::throw_errno("sf_register_event");
+	}
+
+	~subscription()
+	{
+		sf_unregister_event(m_handle, Event::event_type);
+	}
+
+	subscription(const subscription &) = delete;
+	subscription &operator=(const subscription &) = delete;
+
+private:
+	int m_handle;
+	std::decay_t<F> m_fn;
+
+	/* batched events carry several samples, each one is handed over on its own */
+	static void trampoline(unsigned int, sensor_event_data_t *event, void *data)
+	{
+		subscription *self = static_cast<subscription *>(data);
+		typename Event::value_type value;
+		std::size_t i;
+
+		if constexpr (Event::on_time) {
+			const sensor_data_t *samples = static_cast<const sensor_data_t *>(event->event_data);
+
+			for (i = 0; i < event->event_data_size / sizeof(sensor_data_t); i++) {
+				detail::to_sample(samples[i], value);
+				self->m_fn(value);
+			}
+		} else {
+			std::memcpy(&value, event->event_data, sizeof(value));
+			self->m_fn(value);
+		}
+	}
+};
+
+//! A connected sensor, disconnected when destroyed
+template <typename Sensor>
+class device {
+public:
+	device()
+	: m_handle(sf_connect(Sensor::type))
+	{
+		if (m_handle < 0)
+			detail::throw_errno("sf_connect");
+	}
+
+	~device()
+	{
+		sf_disconnect(m_handle);
+	}
+
+	device(const device &) = delete;
+	device &operator=(const device &) = delete;
+
+	int handle(void) const { return m_handle; }
+
+	void start(int option = 0)
+	{
+		if (sf_start(m_handle, option) < 0)
+			detail::throw_errno("sf_start");
+	}
+
+	void stop(void)
+	{
+		if (sf_stop(m_handle) < 0)
+			detail::throw_errno("sf_stop");
+	}
+
+	//! fn(const typename Event::value_type &), for events other than *_REPORT_ON_TIME
+	template <typename Event, typename F>
+	subscription<Event, F> subscribe(F &&fn)
+	{
+		static_assert(std::is_same<typename Event::sensor, Sensor>::value, "event of another sensor");
+		static_assert((Event::event_type >> 16) == Sensor::type, "event_type of another sensor");
+		static_assert(std::is_invocable<F &, const typename Event::value_type &>::value, "callback does not take the value of the event");
+
+		return subscription<Event, F>(m_handle, 0, std::forward<F>(fn));
+	}
+
+	//! fn(const sample<N> &) every interval_ms, for *_REPORT_ON_TIME events
+	template <typename Event, typename F>
+	subscription<Event, F> subscribe(unsigned int interval_ms, F &&fn)
+	{
+		static_assert(std::is_same<typename Event::sensor, Sensor>::value, "event of another sensor");
+		static_assert((Event::event_type >> 16) == Sensor::type, "event_type of another sensor");
+		static_assert(Event::on_time, "an interval is only for *_REPORT_ON_TIME events");
+		static_assert(std::is_invocable<F &, const typename Event::value_type &>::value, "callback does not take the sample of the event");
+
+		return subscription<Event, F>(m_handle, interval_ms, std::forward<F>(fn));
+	}
+
+	//! one sample read with sf_get_data()
+	template <typename Event>
+	typename Event::value_type get(void)
+	{
+		static_assert(std::is_same<typename Event::sensor, Sensor>::value, "event of another sensor");
+		static_assert((Event::event_type >> 16) == Sensor::type, "event_type of another sensor");
+		static_assert(Event::on_time, "sf_get_data() is only for the data of *_REPORT_ON_TIME events");
+
+		sensor_data_t data;
+		typename Event::value_type value;
+
+		if (sf_get_data(m_handle, Event::data_id, &data) < 0)
+			detail::throw_errno("sf_get_data");
+
+		detail::to_sample(data, value);
+		return value;
+	}
+
+private:
+	int m_handle;
+};
+
+}
+
+#endif
+#endif
+//! End of a file
@@ -0,0 +1,326 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <common.h>
+
+#include "cio_uring.h"
+
+/* kernel headers older than io_uring leave every ring unready */
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#define USE_IO_URING
+#endif
+
+cio_uring::cio_uring()
+: m_fd(-1)
+, m_enters(0)
+, m_to_submit(0)
+, m_ring_map(0)
+, m_ring_map_size(0)
+, m_cq_map(0)
+, m_cq_map_size(0)
+, m_sqes(0)
+, m_sqes_size(0)
+, m_sq_head(0)
+, m_sq_tail(0)
+, m_sq_array(0)
+, m_sq_mask(0)
+, m_sq_entries(0)
+, m_cq_head(0)
+, m_cq_tail(0)
+, m_cqes(0)
+, m_cq_mask(0)
+{
+}
+
+cio_uring::~cio_uring()
+{
+	release();
+}
+
+void cio_uring::release(void)
+{
+	if (m_sqes)
+		munmap(m_sqes, m_sqes_size);
+
+	if (m_cq_map && m_cq_map != m_ring_map)
+		munmap(m_cq_map, m_cq_map_size);
+
+	if (m_ring_map)
+		munmap(m_ring_map, m_ring_map_size);
+
+	if (m_fd >= 0)
+		close(m_fd);
+
+	m_fd = -1;
+	m_ring_map = 0;
+	m_cq_map = 0;
+	m_sqes = 0;
+	m_to_submit = 0;
+}
+
+#ifdef USE_IO_URING
+
+bool cio_uring::init(unsigned int entries)
+{
+	struct io_uring_params params;
+	char *ring;
+	char *cq;
+
+	if (m_fd >= 0)
+		return true;
+
+	memset(&params, 0, sizeof(params));
+
+	m_fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (m_fd < 0) {
+		INFO("io_uring_setup fail , errno : %d\n", errno);
+		m_fd = -1;
+		return false;
+	}
+
+	m_ring_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	m_cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) && m_cq_map_size > m_ring_map_size)
+		m_ring_map_size = m_cq_map_size;
+
+	ring = (char *)mmap(NULL, m_ring_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+	if (ring == MAP_FAILED) {
+		ERR("mmap of io_uring sq ring fail , errno : %d\n", errno);
+		m_ring_map = 0;
+		release();
+		return false;
+	}
+	m_ring_map = ring;
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cq = ring;
+	} else {
+		cq = (char *)mmap(NULL, m_cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+		if (cq == MAP_FAILED) {
+			ERR("mmap of io_uring cq ring fail , errno : %d\n", errno);
+			release();
+			return false;
+		}
+	}
+	m_cq_map = cq;
+
+	m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	m_sqes = mmap(NULL, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+	if (m_sqes == MAP_FAILED) {
+		ERR("mmap of io_uring sqes fail , errno : %d\n", errno);
+		m_sqes = 0;
+		release();
+		return false;
+	}
+
+	m_sq_head = (unsigned int *)(ring + params.sq_off.head);
+	m_sq_tail = (unsigned int *)(ring + params.sq_off.tail);
+	m_sq_array = (unsigned int *)(ring + params.sq_off.array);
+	m_sq_mask = *(unsigned int *)(ring + params.sq_off.ring_mask);
+	m_sq_entries = params.sq_entries;
+
+	m_cq_head = (unsigned int *)(cq + params.cq_off.head);
+	m_cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+	m_cqes = cq + params.cq_off.cqes;
+	m_cq_mask = *(unsigned int *)(cq + params.cq_off.ring_mask);
+
+	return true;
+}
+
+void *cio_uring::get_sqe(void)
+{
+	const unsigned int tail = *m_sq_tail;
+	struct io_uring_sqe *sqe;
+
+	__sync_synchronize();
+	if (tail - *m_sq_head >= m_sq_entries)
+		return 0;
+
+	sqe = &((struct io_uring_sqe *)m_sqes)[tail & m_sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	m_sq_array[tail & m_sq_mask] = tail & m_sq_mask;
+
+	return sqe;
+}
+
+bool cio_uring::prep_send(int fd, const void *buf, unsigned int len, unsigned long long user_data, bool link)
+{
+	struct io_uring_sqe *sqe;
+
+	if (m_fd < 0)
+		return false;
+
+	sqe = (struct io_uring_sqe *)get_sqe();
+	if (!sqe)
+		return false;
+
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)buf;
+	sqe->len = len;
+	/* a short send would leave the linked receive waiting for replies never asked for */
+	sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+	sqe->user_data = user_data;
+	if (link)
+		sqe->flags = IOSQE_IO_LINK;
+
+	/* the entry is complete before the kernel can see it */
+	__sync_synchronize();
+	(*m_sq_tail)++;
+	m_to_submit++;
+
+	return true;
+}
+
+bool cio_uring::prep_recv(int fd, void *buf, unsigned int len, unsigned long long user_data)
+{
+	struct io_uring_sqe *sqe;
+
+	if (m_fd < 0)
+		return false;
+
+	sqe = (struct io_uring_sqe *)get_sqe();
+	if (!sqe)
+		return false;
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)buf;
+	sqe->len = len;
+	sqe->user_data = user_data;
+
+	__sync_synchronize();
+	(*m_sq_tail)++;
+	m_to_submit++;
+
+	return true;
+}
+
+unsigned int cio_uring::cq_ready(void)
+{
+	const unsigned int tail = *m_cq_tail;
+
+	__sync_synchronize();
+	return tail - *m_cq_head;
+}
+
+int cio_uring::enter(unsigned int to_submit, unsigned int wait_nr)
+{
+	int ret;
+
+	ret = (int)syscall(__NR_io_uring_enter, m_fd, to_submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	m_enters++;
+
+	if (ret > 0)
+		m_to_submit -= (unsigned int)ret;
+
+	return ret;
+}
+
+bool cio_uring::reap(unsigned long long *user_data, int *res)
+{
+	const struct io_uring_cqe *cqe;
+	unsigned int head;
+
+	if (m_fd < 0 || !cq_ready())
+		return false;
+
+	head = *m_cq_head;
+
+	cqe = &((const struct io_uring_cqe *)m_cqes)[head & m_cq_mask];
+	*user_data = cqe->user_data;
+	*res = cqe->res;
+
+	/* the entry is read before the kernel can reuse it */
+	__sync_synchronize();
+	*m_cq_head = head + 1;
+
+	return true;
+}
+
+#else
+
+bool cio_uring::init(unsigned int entries)
+{
+	return false;
+}
+
+bool cio_uring::prep_send(int fd, const void *buf, unsigned int len, unsigned long long user_data, bool link)
+{
+	return false;
+}
+
+bool cio_uring::prep_recv(int fd, void *buf, unsigned int len, unsigned long long user_data)
+{
+	return false;
+}
+
+unsigned int cio_uring::cq_ready(void)
+{
+	return 0;
+}
+
+int cio_uring::enter(unsigned int to_submit, unsigned int wait_nr)
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+bool cio_uring::reap(unsigned long long *user_data, int *res)
+{
+	return false;
+}
+
+#endif
+
+/* one io_uring_enter() in the usual case, more only when a signal cuts the wait short */
+int cio_uring::submit_and_wait(unsigned int wait_nr)
+{
+	int ret;
+
+	if (m_fd < 0) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	do {
+		ret = enter(m_to_submit, wait_nr);
+		if (ret < 0 && errno != EINTR) {
+			ERR("io_uring_enter fail , errno : %d\n", errno);
+			return -1;
+		}
+	} while (m_to_submit || cq_ready() < wait_nr);
+
+	return 0;
+}
+//! End of a file
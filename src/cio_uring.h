@@ -0,0 +1,79 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#ifndef __SAMSUNG_LINUX_SENSOR_CIO_URING_H__
+#define __SAMSUNG_LINUX_SENSOR_CIO_URING_H__
+
+/*
+ * io_uring submission and completion rings over the raw syscalls, without liburing.
+ * Sends and receives are queued with prep_send() and prep_recv(), then submitted
+ * and waited for with a single io_uring_enter() by submit_and_wait().
+ * init() fails when the kernel, its headers or a seccomp policy do not offer io_uring,
+ * and the caller keeps its plain socket calls.
+ * A ring is used by one thread at a time.
+ */
+class cio_uring {
+public:
+	cio_uring();
+	~cio_uring();
+
+	bool init(unsigned int entries);
+	bool is_ready(void) const { return m_fd >= 0; }
+	unsigned int enters(void) const { return m_enters; }
+
+	bool prep_send(int fd, const void *buf, unsigned int len, unsigned long long user_data, bool link);
+	bool prep_recv(int fd, void *buf, unsigned int len, unsigned long long user_data);
+	int submit_and_wait(unsigned int wait_nr);
+	bool reap(unsigned long long *user_data, int *res);
+
+private:
+	int m_fd;
+	unsigned int m_enters;
+	unsigned int m_to_submit;
+
+	void *m_ring_map;
+	unsigned long m_ring_map_size;
+	void *m_cq_map;							/*m_ring_map when the kernel maps both rings at once*/
+	unsigned long m_cq_map_size;
+	void *m_sqes;
+	unsigned long m_sqes_size;
+
+	volatile unsigned int *m_sq_head;
+	volatile unsigned int *m_sq_tail;
+	unsigned int *m_sq_array;
+	unsigned int m_sq_mask;
+	unsigned int m_sq_entries;
+
+	volatile unsigned int *m_cq_head;
+	volatile unsigned int *m_cq_tail;
+	void *m_cqes;
+	unsigned int m_cq_mask;
+
+	void *get_sqe(void);
+	unsigned int cq_ready(void);
+	int enter(unsigned int to_submit, unsigned int wait_nr);
+	void release(void);
+};
+
+#endif
+//! End of a file
@@ -28,6 +28,10 @@
 #include <netinet/in.h>
 #include <unistd.h>
 #include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,8 +59,12 @@
 #include <vconf.h>
 #include <glib.h>
 #include <sensor.h>
+#include <sensor_record.h>
 #include <errno.h>
 
+#include "ctimer_wheel.h"
+#include "cio_uring.h"
+
 extern int errno;
 
 #ifndef EXTAPI
@@ -67,6 +75,22 @@ extern int errno;
 #define MAX_CB_SLOT_PER_BIND		16
 #define MAX_CB_BIND_SLOT			64
 #define MAX_EVENT_LIST				16
+#define SENSOR_DESC_NUM				9		/*bit number of the last sensor_type_t + 1*/
+#define MAX_STREAM_SLOT				MAX_CB_BIND_SLOT
+#define MAX_GROUP_SLOT				MAX_BIND_SLOT
+#define MAX_LOOP_SLOT				4
+#define IO_RING_SIZE				64		/*power of 2*/
+#define RT_STACK_PREFAULT			(16 * 1024)
+#define EXEC_MAX_WORKER				8
+#define EXEC_BOX_SIZE				16		/*power of 2*/
+#define EXEC_BATCH					8
+#define MAX_RECORD_SLOT				MAX_BIND_SLOT
+#define RECORD_EXTENT_CHUNKS		64		/*file growth step, in SENSOR_RECORD_CHUNK_SIZE chunks*/
+
+/* handle = (generation << HANDLE_SLOT_BITS) | bind slot, generation never 0 */
+#define HANDLE_SLOT_BITS			8
+#define HANDLE_SLOT_MASK			((1 << HANDLE_SLOT_BITS) - 1)
+#define HANDLE_GEN_MASK				(0x7FFFFFFF >> HANDLE_SLOT_BITS)
 
 #define PITCH_MIN 		35
 #define PITCH_MAX 		145
@@ -95,6 +119,12 @@ extern int errno;
 #define XY_NEGATIVE_THD -2.0
 
 #define ON_TIME_REQUEST_COUNTER 1
+#define MAX_ON_TIME_REQUEST_COUNTER 256
+
+#define ADAPTIVE_STILL_SAMPLES	10		/*still samples in a row before the interval doubles*/
+#define ADAPTIVE_AXIS_NUM		3
+
+#define SENSOR_PRIORITY_NUM	(SENSOR_PRIORITY_LOW + 1)
 
 #define VCONF_SF_SERVER_POWER_OFF "memory/private/sensor/poweroff"
 
@@ -121,33 +151,95 @@ enum _sensor_poweroff_state {
 	SENSOR_POWEROFF_AWAKEN  =  1,
 };
 
+/*
+ * Bind and callback slots are split in two parallel arrays sharing the index :
+ * the *_table_t part holds what the tick, delivery and handle validation read,
+ * the *_info_t part holds registration metadata touched only on API calls
+ */
 struct sf_bind_table_t {
-	csock *ipc;	
+	csock *ipc;
+	volatile int my_handle;					/*live handle of the slot, -1 or 0 when free*/
+	int sensor_state;
+	int reply_pending;						/*replies of server_post_reg() not read yet*/
+	int held;								/*ON_TIME delivery held back until the LCD is on*/
+	int loop_slot;							/*g_loop_table slot serving its ON_TIME events, 0 for the default context*/
+	int io_fd;								/*connection of the I/O or real-time thread, -1 when closed, see bind_io_open()*/
+	int io_reopen;							/*1 io_fd is opened on the default context, 2 closed first, see bind_io_reopen()*/
+	int release_pending;					/*held callbacks the real-time thread releases on its next round*/
+};
+
+struct sf_bind_info_t {
 	sensor_type_t sensor_type;	
 	int cb_event_max_num;					/*limit by MAX_BIND_PER_CB_SLOT*/
 	int cb_slot_num[MAX_CB_SLOT_PER_BIND];
-	int my_handle;
-	int sensor_state;
+	unsigned int generation;
 	int wakeup_state;
 	int sensor_option;
+	const char *channel_name;
 };
 
 struct cb_bind_table_t {
-	char call_back_key[MAX_KEY_LEN];
-	void *client_data;
 	void (*sensor_callback_func_t)(unsigned int, sensor_event_data_t *, void *);
+	void *client_data;
 	unsigned int cb_event_type;
-	int my_cb_handle;
 	int my_sf_handle;
 	
-	unsigned int request_count;
 	unsigned int request_data_id;
 	void *collected_data;
+	unsigned int request_count;
 	unsigned int current_collected_idx;
-	
-	GSource *source;
+	unsigned int collected_num;
+	int queue_policy;
+	int priority;
+
+	int stream_slot;
 	guint gsource_interval;
-	guint gID;
+	guint elapsed_interval;
+
+	guint batch_latency;					/*max report latency in ms, 0 delivers every sample*/
+	unsigned long long batch_deadline;
+	ctimer_wheel::entry batch_timer;		/*flushes the batch at batch_deadline when no sample closes it*/
+
+	guint adaptive_interval;				/*slowest adaptive interval in ms, 0 when not adaptive*/
+
+	int exec;								/*callbacks run on the executor, see sf_set_event_executor()*/
+	int record_slot;						/*recorder of the delivered samples, -1 when none*/
+};
+
+struct cb_bind_info_t {
+	char call_back_key[MAX_KEY_LEN];
+	int my_cb_handle;
+	sensor_event_stats_t stats;
+	guint tolerance;						/*ms a tick may be late to share a wakeup*/
+
+	guint adaptive_base;					/*interval asked by the application*/
+	float adaptive_threshold;
+	float adaptive_ref[ADAPTIVE_AXIS_NUM];
+	int adaptive_ref_set;					/*adaptive_ref is taken from the first sample*/
+	unsigned int adaptive_still;
+	guint adaptive_next;					/*retune waiting for adaptive_retune_cb(), 0 when none*/
+
+	int record_chunk;						/*chunk open in the record file of record_slot*/
+};
+
+/* One fetch stream per data_id, shared by every ON_TIME callback subscribing to it */
+struct sf_stream_table_t {
+	unsigned int data_id;
+	int my_stream_slot;
+	unsigned int subscriber_num;
+	int subscriber_list[MAX_CB_BIND_SLOT];
+
+	int loop_slot;							/*subscribers all share the loop of the stream*/
+	ctimer_wheel::entry timer;
+	guint tick_interval;
+	unsigned long long deadline;			/*nominal tick, timer.expires may lag it by timer.slack*/
+};
+
+/* Handles started and stopped together, with their streams ticking in phase */
+struct sf_group_table_t {
+	int in_use;
+	unsigned int handle_num;
+	int handle_list[MAX_BIND_SLOT];
 };
 
 static struct rotation_event rotation_mode[] =
@@ -160,39 +252,328 @@ static struct rotation_event rotation_mode[] =
 };
 
 struct event_counter_t {
-	const unsigned int event_type;
 	unsigned int event_counter;
 	unsigned int cb_list[MAX_BIND_SLOT];
 };
 
-static event_counter_t g_event_list[MAX_EVENT_LIST] = {
-	{ ACCELEROMETER_EVENT_ROTATION_CHECK,      0, {0, }},
-	{ ACCELEROMETER_EVENT_CALIBRATION_NEEDED,  0, {0, }},
-	{ ACCELEROMETER_EVENT_SET_HORIZON,         0, {0, }},
-	{ ACCELEROMETER_EVENT_SET_WAKEUP,          0, {0, }},
-	{ GEOMAGNETIC_EVENT_CALIBRATION_NEEDED,    0, {0, }},
-	{ PROXIMITY_EVENT_CHANGE_STATE, 		   0, {0, }},
-	{ LIGHT_EVENT_CHANGE_LEVEL, 			   0, {0, }},
-	{ MOTION_ENGINE_EVENT_SNAP, 			   0, {0, }},
-	{ MOTION_ENGINE_EVENT_SHAKE, 			   0, {0, }},
-	{ MOTION_ENGINE_EVENT_DOUBLETAP, 		   0, {0, }},
-	{ MOTION_ENGINE_EVENT_PANNING, 			   0, {0, }},
-	{ MOTION_ENGINE_EVENT_TOP_TO_BOTTOM, 	   0, {0, }},
-	{ MOTION_ENGINE_EVENT_DIRECT_CALL, 	       0, {0, }},
-	{ MOTION_ENGINE_EVENT_TILT_TO_UNLOCK,      0, {0, }},
-	{ MOTION_ENGINE_EVENT_LOCK_EXECUTE_CAMERA, 0, {0, }},
-	{ MOTION_ENGINE_EVENT_REACTIVE_ALERT	 , 0, {0, }},
+/* callbacks listening to the vconf key of an event, indexed by sf_event_desc_t::list_slot */
+static event_counter_t g_event_list[MAX_EVENT_LIST];
+
+/*
+ * Every sensor and event known to the library. A sensor_type_t is one bit and so is
+ * the low half of an event_type, their bit numbers index the tables.
+ * An event with a data_id is fetched by a stream, the others follow their vconf key
+ * through the g_event_list slot list_slot.
+ */
+struct sf_event_desc_t {
+	unsigned int event_type;
+	unsigned int data_id;
+	int list_slot;
+};
+
+struct sf_sensor_desc_t {
+	const char *channel_name;
+	int event_num;
+	const sf_event_desc_t *event_list;
+};
+
+#define EVENT_DESC_NUM(list)	((int)(sizeof(list) / sizeof((list)[0])))
+
+static const sf_event_desc_t g_accel_event_desc[] = {
+	{ ACCELEROMETER_EVENT_ROTATION_CHECK,                         0,                                          0 },
+	{ ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME,                ACCELEROMETER_BASE_DATA_SET,                -1 },
+	{ ACCELEROMETER_EVENT_CALIBRATION_NEEDED,                     0,                                          1 },
+	{ ACCELEROMETER_EVENT_SET_HORIZON,                            0,                                          2 },
+	{ ACCELEROMETER_EVENT_SET_WAKEUP,                             0,                                          3 },
+	{ ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME,        ACCELEROMETER_ORIENTATION_DATA_SET,         -1 },
+	{ ACCELEROMETER_EVENT_LINEAR_ACCELERATION_DATA_REPORT_ON_TIME, ACCELEROMETER_LINEAR_ACCELERATION_DATA_SET, -1 },
+};
+
+static const sf_event_desc_t g_geomag_event_desc[] = {
+	{ GEOMAGNETIC_EVENT_CALIBRATION_NEEDED,           0,                             4 },
+	{ GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME,      GEOMAGNETIC_RAW_DATA_SET,      -1 },
+	{ GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME, GEOMAGNETIC_ATTITUDE_DATA_SET, -1 },
+};
+
+static const sf_event_desc_t g_light_event_desc[] = {
+	{ LIGHT_EVENT_CHANGE_LEVEL,              0,                   6 },
+	{ LIGHT_EVENT_LEVEL_DATA_REPORT_ON_TIME, LIGHT_BASE_DATA_SET, -1 },
+	{ LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME,   LIGHT_LUX_DATA_SET,  -1 },
+};
+
+static const sf_event_desc_t g_proxi_event_desc[] = {
+	{ PROXIMITY_EVENT_CHANGE_STATE,                0,                           5 },
+	{ PROXIMITY_EVENT_STATE_REPORT_ON_TIME,        PROXIMITY_BASE_DATA_SET,     -1 },
+	{ PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME, PROXIMITY_DISTANCE_DATA_SET, -1 },
+};
+
+static const sf_event_desc_t g_gyro_event_desc[] = {
+	{ GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME, GYRO_BASE_DATA_SET, -1 },
+};
+
+static const sf_event_desc_t g_barometer_event_desc[] = {
+	{ BAROMETER_EVENT_RAW_DATA_REPORT_ON_TIME,         BAROMETER_BASE_DATA_SET,        -1 },
+	{ BAROMETER_EVENT_TEMPERATURE_DATA_REPORT_ON_TIME, BAROMETER_TEMPERATURE_DATA_SET, -1 },
+	{ BAROMETER_EVENT_ALTITUDE_DATA_REPORT_ON_TIME,    BAROMETER_ALTITUDE_DATA_SET,    -1 },
+};
+
+static const sf_event_desc_t g_motion_event_desc[] = {
+	{ MOTION_ENGINE_EVENT_SNAP,                0, 7 },
+	{ MOTION_ENGINE_EVENT_SHAKE,               0, 8 },
+	{ MOTION_ENGINE_EVENT_DOUBLETAP,           0, 9 },
+	{ MOTION_ENGINE_EVENT_PANNING,             0, 10 },
+	{ MOTION_ENGINE_EVENT_TOP_TO_BOTTOM,       0, 11 },
+	{ MOTION_ENGINE_EVENT_DIRECT_CALL,         0, 12 },
+	{ MOTION_ENGINE_EVENT_TILT_TO_UNLOCK,      0, 13 },
+	{ MOTION_ENGINE_EVENT_LOCK_EXECUTE_CAMERA, 0, 14 },
+	{ MOTION_ENGINE_EVENT_REACTIVE_ALERT,      0, 15 },
+};
+
+static const sf_event_desc_t g_fusion_event_desc[] = {
+	{ FUSION_SENSOR_EVENT_RAW_DATA_REPORT_ON_TIME,      FUSION_BASE_DATA_SET,            -1 },
+	{ FUSION_ROTATION_VECTOR_EVENT_DATA_REPORT_ON_TIME, FUSION_ROTATION_VECTOR_DATA_SET, -1 },
+	{ FUSION_ROTATION_MATRIX_EVENT_DATA_REPORT_ON_TIME, FUSION_ROTATION_MATRIX_DATA_SET, -1 },
+};
+
+static const sf_sensor_desc_t g_sensor_desc[SENSOR_DESC_NUM] = {
+	{ ACCEL_SENSOR_BASE_CHANNEL_NAME,     EVENT_DESC_NUM(g_accel_event_desc),     g_accel_event_desc },		/*ACCELEROMETER_SENSOR*/
+	{ GEOMAG_SENSOR_BASE_CHANNEL_NAME,    EVENT_DESC_NUM(g_geomag_event_desc),    g_geomag_event_desc },	/*GEOMAGNETIC_SENSOR*/
+	{ LIGHT_SENSOR_BASE_CHANNEL_NAME,     EVENT_DESC_NUM(g_light_event_desc),     g_light_event_desc },		/*LIGHT_SENSOR*/
+	{ PROXI_SENSOR_BASE_CHANNEL_NAME,     EVENT_DESC_NUM(g_proxi_event_desc),     g_proxi_event_desc },		/*PROXIMITY_SENSOR*/
+	{ NULL,                               0,                                      NULL },					/*THERMOMETER_SENSOR*/
+	{ GYRO_SENSOR_BASE_CHANNEL_NAME,      EVENT_DESC_NUM(g_gyro_event_desc),      g_gyro_event_desc },		/*GYROSCOPE_SENSOR*/
+	{ BAROMETER_SENSOR_BASE_CHANNEL_NAME, EVENT_DESC_NUM(g_barometer_event_desc), g_barometer_event_desc },	/*BAROMETER_SENSOR*/
+	{ MOTION_ENGINE_BASE_CHANNEL_NAME,    EVENT_DESC_NUM(g_motion_event_desc),    g_motion_event_desc },	/*MOTION_SENSOR*/
+	{ FUSION_SENSOR_BASE_CHANNEL_NAME,    EVENT_DESC_NUM(g_fusion_event_desc),    g_fusion_event_desc },	/*FUSION_SENSOR*/
 };
 
 static sf_bind_table_t g_bind_table[MAX_BIND_SLOT];
+static sf_bind_info_t g_bind_info[MAX_BIND_SLOT];
 
 static cb_bind_table_t g_cb_table[MAX_CB_BIND_SLOT];
+static cb_bind_info_t g_cb_info[MAX_CB_BIND_SLOT];
+
+static sf_stream_table_t g_stream_table[MAX_STREAM_SLOT];
+
+static sf_group_table_t g_group_table[MAX_GROUP_SLOT];
+
+/* An mmap'ed record file, shared by the subscriptions of sf_record_start() */
+struct sf_record_table_t {
+	int in_use;
+	int fd;
+	char *map;
+	size_t map_size;						/*bytes mapped, the size of the file*/
+	unsigned int cb_num;					/*subscriptions writing to the file*/
+	int locked;								/*written by the real-time thread, the mapping stays resident*/
+};
+
+static sf_record_table_t g_record_table[MAX_RECORD_SLOT];
+
+/*
+ * Samples fetched by the I/O thread on their way to the loop of their stream.
+ * The I/O thread is the only producer and the loop the only consumer,
+ * so head and tail each have a single writer and need no lock.
+ */
+struct io_record_t {
+	int stream_slot;
+	unsigned int data_id;
+	guint tick;
+	int batch_cb;							/*subscription whose batch deadline expired, -1 for a sample*/
+	sensor_data_t sample;
+};
+
+/* a stream due in the current wheel run, see stream_fetch_flush() */
+struct sf_fetch_t {
+	int stream_slot;
+	unsigned int data_id;
+	int handle;
+	guint tick;
+	int state;
+	sensor_data_t sample;
+};
+
+struct io_ring_t {
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	io_record_t record[IO_RING_SIZE];
+};
+
+/*
+ * Timer wheel and delivery sources of one GMainContext, see sf_set_main_context().
+ * Slot 0 serves the default context and is never released,
+ * other slots live as long as a handle uses their context.
+ */
+struct sf_loop_table_t {
+	int in_use;
+	unsigned int bind_num;
+	GMainContext *context;
+	ctimer_wheel wheel;
+	GSource *timer_source;
+	GPollFD timer_pollfd;
+	GSource *delivery_source[SENSOR_PRIORITY_NUM];	/*one per sensor_event_priority class, indexed by class*/
+	unsigned int delivery_pending[SENSOR_PRIORITY_NUM];
+	GSource *io_source;						/*drains io_ring while the I/O thread runs*/
+	GPollFD io_pollfd;
+	int io_notify_fd;
+	unsigned int io_dropped;
+	io_ring_t io_ring;
+	unsigned int fetch_num;
+	sf_fetch_t fetch[MAX_STREAM_SLOT];
+	cio_uring uring;						/*fetch ring, see stream_fetch_uring()*/
+	char *uring_buf;						/*requests and replies of the ring, kept for the life of the process*/
+	int rt;									/*served by the real-time thread instead of a GMainContext*/
+	unsigned int rt_ticks;
+	unsigned int rt_jitter_max_us;
+	unsigned long long rt_jitter_sum_us;
+};
+
+static sf_loop_table_t g_loop_table[MAX_LOOP_SLOT];
+
+/* io_uring fetch : 0 not tried yet, 1 in use, -1 unavailable and the socket fetch serves every run */
+static volatile int g_uring_state = 0;
+
+/*
+ * Optional I/O thread, see sf_set_io_thread() : it runs the stream wheels of every loop.
+ * g_io_lock serializes it with wheel and stream changes made by the other threads,
+ * and is only taken while the thread runs.
+ */
+static pthread_mutex_t g_io_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static volatile int g_io_thread_on = 0;
+static volatile int g_io_thread_stop = 0;
+static pthread_t g_io_thread;
+static int g_io_epfd = -1;
+static int g_io_wake_fd = -1;
+
+/* Real-time delivery thread, see sf_set_rt_delivery(), serving the loop slot g_rt_slot */
+static volatile int g_rt_thread_on = 0;
+static pthread_t g_rt_thread;
+static int g_rt_epfd = -1;
+static int g_rt_slot = -1;
+
+/*
+ * Optional callback executor, see sf_set_event_executor() : a pool of workers,
+ * each with a deque of the subscriptions (cb slots) having samples in their exec_box.
+ * A subscription is in at most one deque or on one worker at a time,
+ * which keeps its samples in order while different subscriptions run in parallel.
+ * exec_box_t::lock is taken before exec_worker_t::lock, g_exec_lock is taken alone.
+ */
+enum exec_box_state {
+	EXEC_IDLE = 0,
+	EXEC_QUEUED,
+	EXEC_RUNNING,
+};
+
+struct exec_box_t {
+	pthread_mutex_t lock;
+	pthread_cond_t done;					/*signaled when a worker leaves the box*/
+	int state;
+	pthread_t runner;
+	unsigned int head;
+	unsigned int tail;
+	sensor_callback_func_t func;
+	unsigned int event_type;
+	void *client_data;
+	sensor_data_t sample[EXEC_BOX_SIZE];
+};
+
+struct exec_worker_t {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	unsigned int top;						/*stolen from*/
+	unsigned int bottom;					/*pushed and popped by the owner*/
+	int task[MAX_CB_BIND_SLOT];				/*MAX_CB_BIND_SLOT is a power of 2*/
+};
+
+static pthread_mutex_t g_exec_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_exec_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int g_exec_task_num = 0;
+static int g_exec_worker_num = 0;
+static exec_worker_t g_exec_worker[EXEC_MAX_WORKER];
+static exec_box_t g_exec_box[MAX_CB_BIND_SLOT];
+
+struct loop_source_t {
+	GSource source;
+	int loop_slot;
+};
+
+struct delivery_source_t {
+	GSource source;
+	int loop_slot;
+	int priority_class;
+};
+
+static const gint g_delivery_priority[SENSOR_PRIORITY_NUM] = {
+	G_PRIORITY_DEFAULT,
+	G_PRIORITY_HIGH,
+	G_PRIORITY_LOW,
+};
+
+
+/* classes in the order sf_dispatch_pending() serves them, as the glib priorities would */
+static const int g_delivery_order[SENSOR_PRIORITY_NUM] = {
+	SENSOR_PRIORITY_HIGH,
+	SENSOR_PRIORITY_DEFAULT,
+	SENSOR_PRIORITY_LOW,
+};
+
+/*
+ * Readiness for applications without a glib loop, see sf_get_event_fd() :
+ * an epoll fd over the timer wheel fd and an eventfd raised while samples wait
+ */
+static int g_event_fd = -1;
+static int g_event_notify_fd = -1;
+static int g_event_notified = 0;
+
+static void stream_timer_expired(void *data);
+static void batch_timer_cancel(int cb_number);
+static void stream_fanout(sf_stream_table_t *stream, const sensor_data_t *sample, guint tick);
+static void io_thread_stop_wait(int joinable);
+static int rt_wheel_attach(int loop_slot);
+static void stream_fetch_flush(int loop_slot);
+static inline void io_lock(void);
+static inline void io_unlock(void);
+static int server_post_reg(int handle, unsigned int event_type, unsigned int interval);
+static void bind_suspend_all(void);
+static void bind_resume_all(void);
+static void bind_teardown_all(void);
+static void bind_io_close(int slot);
+static void bind_io_sync(int slot);
+
+static const sf_sensor_desc_t *sensor_desc(unsigned int sensor_type)
+{
+	int idx;
+
+	if (!sensor_type || (sensor_type & (sensor_type - 1)))
+		return NULL;
+
+	idx = __builtin_ctz(sensor_type);
+	if (idx >= SENSOR_DESC_NUM || !g_sensor_desc[idx].channel_name)
+		return NULL;
+
+	return &g_sensor_desc[idx];
+}
+
+
+static const sf_event_desc_t *event_desc(unsigned int event_type)
+{
+	const sf_sensor_desc_t *sensor = sensor_desc(event_type >> 16);
+	const unsigned int event_bit = event_type & 0xFFFF;
+	int idx;
+
+	if (!sensor || !event_bit || (event_bit & (event_bit - 1)))
+		return NULL;
+
+	idx = __builtin_ctz(event_bit);
+	if (idx >= sensor->event_num || sensor->event_list[idx].event_type != event_type)
+		return NULL;
+
+	return &sensor->event_list[idx];
+}
 
-static gboolean sensor_timeout_handler(gpointer data);
 
 inline static void add_cb_number(int list_slot, unsigned int cb_number)
 {
-	if(list_slot < 0 || list_slot > MAX_EVENT_LIST)
+	if(list_slot < 0 || list_slot >= MAX_EVENT_LIST)
 		return;
 
 	unsigned int i = 0;
@@ -215,7 +596,7 @@ inline static void add_cb_number(int list_slot, unsigned int cb_number)
 
 inline static void del_cb_number(int list_slot, unsigned int cb_number)
 {
-	if(list_slot < 0 || list_slot > MAX_EVENT_LIST)
+	if(list_slot < 0 || list_slot >= MAX_EVENT_LIST)
 		return;
 
 	unsigned int i = 0, j = 0;
@@ -238,1925 +619,5748 @@ inline static void del_cb_number(int list_slot, unsigned int cb_number)
 
 inline static void del_cb_by_event_type(unsigned int event_type, unsigned int cb_number)
 {
-	int list_slot = 0;
+	const sf_event_desc_t *desc = event_desc(event_type);
 
-	for(list_slot = 0 ; list_slot < MAX_EVENT_LIST ; list_slot++)
-		if(g_event_list[list_slot].event_type == event_type)
-			break;
+	if(desc)
+		del_cb_number(desc->list_slot, cb_number);
+}
+
+
+/*
+ * collected_data of an ON_TIME callback is a ring of request_count samples,
+ * filled by its stream and drained by the delivery source.
+ * Samples of a held handle or a batching callback stay out of delivery_pending,
+ * they leave the ring through queue_deliver_batch().
+ */
+static inline void event_notify(void)
+{
+	const unsigned long long one = 1;
+
+	if ( g_event_notify_fd < 0 || g_event_notified ) {
+		return;
+	}
 
-	del_cb_number(list_slot, cb_number);
+	if ( write(g_event_notify_fd, &one, sizeof(one)) == sizeof(one) ) {
+		g_event_notified = 1;
+	}
 }
 
 
-inline static int acquire_handle(void)
+static inline void queue_account(int cb_number, int delta)
 {
-	register int i;
-	_lock.lock();
-	for (i = 0; i < MAX_BIND_SLOT; i ++) {
-		if (g_bind_table[i].ipc == NULL) break;
+	const int loop_slot = g_bind_table[g_cb_table[cb_number].my_sf_handle].loop_slot;
+
+	if ( !g_bind_table[g_cb_table[cb_number].my_sf_handle].held && !g_cb_table[cb_number].batch_latency ) {
+		g_loop_table[loop_slot].delivery_pending[g_cb_table[cb_number].priority] += delta;
+
+		if ( delta > 0 && loop_slot == 0 ) {
+			event_notify();
+		}
 	}
-	_lock.unlock();
+}
 
-	return i;
+
+static void queue_reset(int cb_number)
+{
+	batch_timer_cancel(cb_number);
+	queue_account(cb_number, -(int)g_cb_table[cb_number].collected_num);
+	g_cb_table[cb_number].collected_num = 0;
+	g_cb_table[cb_number].current_collected_idx = 0;
+
+	if ( g_cb_table[cb_number].collected_data ) {
+		delete [] (sensor_data_t *)g_cb_table[cb_number].collected_data;
+		g_cb_table[cb_number].collected_data = NULL;
+	}
 }
 
 
-inline static int cb_acquire_handle(void)
+/* memory the real-time thread writes per sample stays resident, a page fault is a missed deadline */
+static void rt_mlock(const void *addr, size_t len)
 {
-	register int i;
-	_lock.lock();
-	for (i = 0; i < MAX_CB_BIND_SLOT; i ++) {
-		if (g_cb_table[i].sensor_callback_func_t == NULL) break;
+	if ( mlock(addr, len) < 0 ) {
+		ERR("mlock of real-time memory fail , errno : %d\n", errno);
 	}
-	_lock.unlock();
+}
 
-	return i;
+
+static int queue_alloc(int cb_number, unsigned int depth, int policy)
+{
+	sensor_data_t *queue;
+
+	queue = new sensor_data_t [depth];
+	if ( !queue ) {
+		ERR("memory allocation fail for gathering datas\n");
+		return -1;
+	}
+
+	if ( g_loop_table[g_bind_table[g_cb_table[cb_number].my_sf_handle].loop_slot].rt ) {
+		rt_mlock(queue, sizeof(sensor_data_t) * depth);
+	}
+
+	g_cb_info[cb_number].stats.dropped += g_cb_table[cb_number].collected_num;
+	queue_reset(cb_number);
+
+	g_cb_table[cb_number].collected_data = (void *)queue;
+	g_cb_table[cb_number].request_count = depth;
+	g_cb_table[cb_number].queue_policy = policy;
+
+	return 0;
 }
 
 
-inline static void release_handle(int i)
+static inline bool queue_is_full(int cb_number)
 {
-	register int j;
-	
-	_lock.lock();
-	delete g_bind_table[i].ipc;
-	g_bind_table[i].ipc = NULL;
-	g_bind_table[i].sensor_type = UNKNOWN_SENSOR;
-	
-	g_bind_table[i].my_handle = -1;
-	g_bind_table[i].sensor_state = SENSOR_STATE_UNKNOWN;
-	g_bind_table[i].wakeup_state = SENSOR_WAKEUP_UNKNOWN;
-	g_bind_table[i].sensor_option = SENSOR_OPTION_DEFAULT;
+	return g_cb_table[cb_number].collected_num >= g_cb_table[cb_number].request_count;
+}
+
 
-	for (j=0; j<g_bind_table[i].cb_event_max_num; j++) {
-		if (   (j<MAX_CB_SLOT_PER_BIND) && (g_bind_table[i].cb_slot_num[j] > -1)  ) {
-			del_cb_by_event_type(g_cb_table[g_bind_table[i].cb_slot_num[j]].cb_event_type, g_bind_table[i].cb_slot_num[j]);
-			g_cb_table[g_bind_table[i].cb_slot_num[j]].client_data= NULL;
-			g_cb_table[g_bind_table[i].cb_slot_num[j]].sensor_callback_func_t = NULL;
-			g_cb_table[g_bind_table[i].cb_slot_num[j]].cb_event_type = 0x00;
-			g_cb_table[g_bind_table[i].cb_slot_num[j]].my_cb_handle = -1;
-			g_bind_table[i].cb_slot_num[j] = -1;
+static void queue_push(int cb_number, const sensor_data_t *sample)
+{
+	cb_bind_table_t *cb = &g_cb_table[cb_number];
+	sensor_event_stats_t *stats = &g_cb_info[cb_number].stats;
+	sensor_data_t *queue = (sensor_data_t *)cb->collected_data;
+	unsigned int tail;
+
+	if ( queue_is_full(cb_number) ) {
+		switch ( cb->queue_policy ) {
+			case SENSOR_QUEUE_DROP_NEWEST:
+				stats->dropped++;
+				return;
+			case SENSOR_QUEUE_COALESCE:
+				tail = (cb->current_collected_idx + cb->collected_num - 1) % cb->request_count;
+				memcpy(&queue[tail], sample, sizeof(sensor_data_t));
+				stats->coalesced++;
+				return;
+			case SENSOR_QUEUE_DROP_OLDEST:
+				/* fall through */
+			default:
+				cb->current_collected_idx = (cb->current_collected_idx + 1) % cb->request_count;
+				cb->collected_num--;
+				queue_account(cb_number, -1);
+				stats->dropped++;
+				break;
 		}
 	}
-	
-	g_bind_table[i].cb_event_max_num = 0;
-	
-	_lock.unlock();
+
+	tail = (cb->current_collected_idx + cb->collected_num) % cb->request_count;
+	memcpy(&queue[tail], sample, sizeof(sensor_data_t));
+	cb->collected_num++;
+	queue_account(cb_number, 1);
+
+	if ( cb->collected_num > stats->max_queued ) {
+		stats->max_queued = cb->collected_num;
+	}
 }
 
 
-inline static void cb_release_handle(int i)
+static bool queue_pop(int cb_number, sensor_data_t *sample)
 {
-	_lock.lock();
-	g_cb_table[i].client_data= NULL;
-	g_cb_table[i].sensor_callback_func_t = NULL;
-	g_cb_table[i].cb_event_type = 0x00;
-	g_cb_table[i].my_cb_handle = -1;
-	g_cb_table[i].my_sf_handle = -1;
-	
-	g_cb_table[i].request_count = 0;
-	g_cb_table[i].request_data_id = 0;
-	
-	if ( g_cb_table[i].collected_data )
-	{
-		free (g_cb_table[i].collected_data);
-		g_cb_table[i].collected_data = NULL;
+	cb_bind_table_t *cb = &g_cb_table[cb_number];
+
+	if ( !cb->collected_num || !cb->collected_data ) {
+		return false;
 	}
-	
-	g_cb_table[i].collected_data = NULL;
-	g_cb_table[i].current_collected_idx = 0;
 
-	g_cb_table[i].source = NULL;
-	g_cb_table[i].gsource_interval = 0;
-	g_cb_table[i].gID = 0;
-	_lock.unlock();
+	memcpy(sample, &((sensor_data_t *)cb->collected_data)[cb->current_collected_idx], sizeof(sensor_data_t));
+	cb->current_collected_idx = (cb->current_collected_idx + 1) % cb->request_count;
+	cb->collected_num--;
+	queue_account(cb_number, -1);
+
+	return true;
 }
 
 
-void power_off_cb(keynode_t *node, void *data)
+/* Hand the whole ring to the callback at once, oldest sample first */
+static void queue_deliver_batch(int cb_number)
 {
-	int val = -1;
-	int handle = -1, j = -1;
-	int state = -1;
+	const unsigned int num = g_cb_table[cb_number].collected_num;
+	sensor_event_data_t cb_data;
+	sensor_data_t *batch;
+	unsigned int k;
 
-	if(vconf_keynode_get_type(node) != VCONF_TYPE_INT)
-	{
-		ERR("Errer invailed keytype");
+	if ( !num || !g_cb_table[cb_number].sensor_callback_func_t ) {
 		return;
 	}
 
-	val = vconf_keynode_get_int(node);
-
-	switch(val)
-	{
-		case SENSOR_POWEROFF_AWAKEN:
-			for(handle = 0 ; handle < MAX_BIND_SLOT ; handle++)
-			{
-				if(g_bind_table[handle].ipc != NULL)
-				{
-					state = sf_stop(handle);
+	batch = new sensor_data_t [num];
+	if ( !batch ) {
+		ERR("memory allocation fail for batch of %u samples\n", num);
+		return;
+	}
 
-					if(state < 0)
-					{
-						ERR("Cannot stop handle [%d]",handle);
-						continue;
-					}
-					else
-					{
-						DBG("LCD OFF and sensor handle [%d] stopped",handle);
-					}
+	for ( k = 0 ; k < num ; k++ ) {
+		queue_pop(cb_number, &batch[k]);
+	}
 
-					for(j = 0 ; j < g_bind_table[handle].cb_event_max_num ; j++)
-					{
-						if((j<MAX_CB_SLOT_PER_BIND) && (g_bind_table[handle].cb_slot_num[j] > -1))
-						{
-							state = sf_unregister_event(handle ,g_cb_table[g_bind_table[handle].cb_slot_num[j]].cb_event_type);
+	batch_timer_cancel(cb_number);
 
-							if(state < 0)
-								ERR("cannot unregster_event for event [%x], handle [%d]",g_cb_table[g_bind_table[handle].cb_slot_num[j]].cb_event_type,	handle);
-						}
-					}
+	g_cb_info[cb_number].stats.delivered += num;
 
-					sf_disconnect(handle);
-				}
-			}
-			break;
+	cb_data.event_data_size = sizeof(sensor_data_t) * num;
+	cb_data.event_data = batch;
 
-		default:
-			break;
+	g_cb_table[cb_number].sensor_callback_func_t( g_cb_table[cb_number].cb_event_type , &cb_data , g_cb_table[cb_number].client_data);
 
-	}
+	delete [] batch;
 }
 
 
-void lcd_off_cb(keynode_t *node, void *data)
+/*
+ * Recorder, see sf_record_start() : samples delivered to a subscription are appended
+ * to the open chunk of that subscription in a file mapped MAP_SHARED.
+ * The file grows by RECORD_EXTENT_CHUNKS chunks at a time, the only syscalls of the path.
+ */
+static int record_open(const char *path)
 {
-	int val = -1;
-	int i = -1, j = -1;
+	sf_record_table_t *record;
+	sensor_record_header_t *header;
+	const size_t map_size = (size_t)RECORD_EXTENT_CHUNKS * SENSOR_RECORD_CHUNK_SIZE;
+	int fd;
+	int i;
 
-	if(vconf_keynode_get_type(node) != VCONF_TYPE_INT)
-	{
-		ERR("Errer invailed keytype");
-		return;
+	for (i = 0; i < MAX_RECORD_SLOT && g_record_table[i].in_use; i++);
+	if (i == MAX_RECORD_SLOT) {
+		ERR("MAX_RECORD_SLOT, Too many recorder required");
+		errno = ENOMEM;
+		return -1;
 	}
 
-	val = vconf_keynode_get_int(node);
+	record = &g_record_table[i];
 
-	switch(val)
-	{
-		case VCONFKEY_PM_STATE_LCDOFF:   // LCD OFF
-			for(i = 0 ; i < MAX_BIND_SLOT ; i++)
-			{
-				if((g_bind_table[i].wakeup_state != SENSOR_WAKEUP_SETTED && g_bind_table[i].sensor_option != SENSOR_OPTION_ALWAYS_ON ) && g_bind_table[i].ipc != NULL)
-				{
-					if(g_bind_table[i].sensor_state == SENSOR_STATE_STARTED)
-					{
-						if(sf_stop(i) < 0)
-						{
-							ERR("Cannot stop handle [%d]",i);
-						}
-						else
-						{
-							g_bind_table[i].sensor_state = SENSOR_STATE_PAUSED;
-
-							for(j = -1; j < g_bind_table[i].cb_event_max_num; j++) 
-							{
-								if(g_cb_table[g_bind_table[i].cb_slot_num[j]].collected_data !=  NULL)
-								{
-									g_source_destroy(g_cb_table[g_bind_table[i].cb_slot_num[j]].source);
-									g_source_unref(g_cb_table[g_bind_table[i].cb_slot_num[j]].source);
-								}
-							}
-
-						}
-					}
-					DBG("LCD OFF and sensor handle [%d] stopped",i);
-				}
-			}
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		ERR("cannot open record file %s , errno : %d\n", path, errno);
+		return -1;
+	}
 
-			break;
-		case VCONFKEY_PM_STATE_NORMAL:  // LCD ON
-			for(i = 0 ; i < MAX_BIND_SLOT ; i++)
-			{
-				if(g_bind_table[i].sensor_state == SENSOR_STATE_PAUSED)
-				{
-					if(sf_start(i,g_bind_table[i].sensor_option) < 0)
-					{
-						ERR("Cannot start handle [%d]",i);
-					}
-					else
-					{
-						for(j = -1; j < g_bind_table[i].cb_event_max_num; j++) 
-						{
-							if(g_cb_table[g_bind_table[i].cb_slot_num[j]].collected_data !=  NULL)
-							{
-								g_cb_table[g_bind_table[i].cb_slot_num[j]].source =	g_timeout_source_new(g_cb_table[g_bind_table[i].cb_slot_num[j]].gsource_interval);
-								g_source_set_callback(g_cb_table[g_bind_table[i].cb_slot_num[j]].source, sensor_timeout_handler, (gpointer)&g_cb_table[g_bind_table[i].cb_slot_num[j]].my_cb_handle,NULL);
-								g_cb_table[g_bind_table[i].cb_slot_num[j]].gID = g_source_attach(g_cb_table[g_bind_table[i].cb_slot_num[j]].source,	NULL);
-							}
-						}
-					}
-					DBG("LCD ON and sensor handle [%d] started",i);
-				}
-			}
+	if (ftruncate(fd, map_size) < 0) {
+		ERR("ftruncate fail , errno : %d\n", errno);
+		close(fd);
+		return -1;
+	}
 
-			break;
-		default :
-			break ;
+	record->map = (char *)mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (record->map == MAP_FAILED) {
+		ERR("mmap fail , errno : %d\n", errno);
+		record->map = NULL;
+		close(fd);
+		return -1;
 	}
-}
 
-int system_off_set(void)
-{
-	int result = -1;
-	if(g_system_off_cb_ct == 0)
-	{
-		result = vconf_notify_key_changed(VCONFKEY_PM_STATE, lcd_off_cb, NULL);
-		if(result < 0)
-		{
-			ERR("cannot setting lcd_off_set_cb");
-		}
-		
-		result = vconf_notify_key_changed(VCONF_SF_SERVER_POWER_OFF, power_off_cb, NULL);
-		if(result < 0)
-		{
-			ERR("cannot setting power_off_set_cb");
-		}
+	header = (sensor_record_header_t *)record->map;
+	memcpy(header->magic, SENSOR_RECORD_MAGIC, sizeof(header->magic));
+	header->version = SENSOR_RECORD_VERSION;
+	header->chunk_size = SENSOR_RECORD_CHUNK_SIZE;
+	header->chunk_num = 1;
 
-		g_system_off_cb_ct++;
-	}
-	else if (g_system_off_cb_ct > 0)
-	{
-		g_system_off_cb_ct++;
-	}
-	else
-	{
-		ERR("g_system_off_cb_ct is negative");
-		return -1;
-	}
+	record->in_use = 1;
+	record->fd = fd;
+	record->map_size = map_size;
+	record->cb_num = 0;
+	record->locked = 0;
 
-	DBG("system_off_set success");
-	return 1;
+	return i;
 }
-	
-int system_off_unset(void)
+
+
+/* the file keeps the chunks in use, the rest of the last extent is cut */
+static void record_close(int record_slot)
 {
-	int result = -1;
-	if(g_system_off_cb_ct == 1)
-	{
-		result = vconf_ignore_key_changed(VCONFKEY_PM_STATE, lcd_off_cb);
-		if(result < 0)
-		{
-			ERR("cannot setting lcd_off_set_cb");
+	sf_record_table_t *record = &g_record_table[record_slot];
+	const sensor_record_header_t *header = (sensor_record_header_t *)record->map;
+
+	if (ftruncate(record->fd, (off_t)header->chunk_num * SENSOR_RECORD_CHUNK_SIZE) < 0)
+		ERR("ftruncate fail , errno : %d\n", errno);
+
+	munmap(record->map, record->map_size);
+	close(record->fd);
+
+	record->map = NULL;
+	record->fd = -1;
+	record->map_size = 0;
+	record->locked = 0;
+	record->in_use = 0;
+}
+
+
+/* a file the real-time thread writes to stays resident, extents included */
+static void record_lock(int record_slot)
+{
+	sf_record_table_t *record = &g_record_table[record_slot];
+
+	if (record->locked)
+		return;
+
+	record->locked = 1;
+	rt_mlock(record->map, record->map_size);
+}
+
+
+static int record_chunk_alloc(int cb_number, const sensor_data_t *sample, unsigned int values_num)
+{
+	sf_record_table_t *record = &g_record_table[g_cb_table[cb_number].record_slot];
+	sensor_record_header_t *header = (sensor_record_header_t *)record->map;
+	sensor_record_chunk_t *chunk;
+	const unsigned int chunk_idx = header->chunk_num;
+	size_t map_size;
+	char *map;
+
+	if ((size_t)(chunk_idx + 1) * SENSOR_RECORD_CHUNK_SIZE > record->map_size) {
+		map_size = record->map_size + (size_t)RECORD_EXTENT_CHUNKS * SENSOR_RECORD_CHUNK_SIZE;
+
+		if (ftruncate(record->fd, map_size) < 0) {
+			ERR("ftruncate fail , errno : %d\n", errno);
+			return -1;
 		}
 
-		result = vconf_ignore_key_changed(VCONF_SF_SERVER_POWER_OFF, power_off_cb);
-		if(result < 0)
-		{
-			ERR("cannot setting power_off_set_cb");
+		map = (char *)mremap(record->map, record->map_size, map_size, MREMAP_MAYMOVE);
+		if (map == MAP_FAILED) {
+			ERR("mremap fail , errno : %d\n", errno);
+			return -1;
 		}
 
-		g_system_off_cb_ct = 0;
-	}
-	else if (g_system_off_cb_ct > 1)
-	{
-		g_system_off_cb_ct--;
-	}
-	else
-	{
-		ERR("g_system_off_cb_ct is negative");
-		return -1;
+		record->map = map;
+		record->map_size = map_size;
+		header = (sensor_record_header_t *)map;
+
+		if (record->locked)
+			rt_mlock(map, map_size);
 	}
-	DBG("system_off_unset success");
 
-	return 1;
+	chunk = SENSOR_RECORD_CHUNK(record->map, chunk_idx);
+	chunk->data_id = g_cb_table[cb_number].request_data_id;
+	chunk->sample_num = 0;
+	chunk->values_num = (unsigned short)values_num;
+	chunk->data_unit_idx = (short)sample->data_unit_idx;
+	chunk->sample_max = (SENSOR_RECORD_CHUNK_SIZE - sizeof(sensor_record_chunk_t)) /
+		(sizeof(unsigned long long) + sizeof(float) * values_num + sizeof(signed char));
+	chunk->first_ts = sample->time_stamp;
+	chunk->last_ts = sample->time_stamp;
+
+	header->chunk_num = chunk_idx + 1;
+	g_cb_info[cb_number].record_chunk = (int)chunk_idx;
+
+	return 0;
 }
-	
 
-void lcd_off_set_wake_up(keynode_t *node, void *data)
+
+static void record_sample(int cb_number, const sensor_data_t *sample)
 {
-	int state = 0;
+	const sf_record_table_t *record = &g_record_table[g_cb_table[cb_number].record_slot];
+	const unsigned int values_num = (sample->values_num > 0 && sample->values_num <= MAX_VALUE_SIZE) ? sample->values_num : MAX_VALUE_SIZE;
+	sensor_record_chunk_t *chunk = NULL;
+	unsigned int n;
+	unsigned int v;
 
-	state = sf_set_property(ACCELEROMETER_SENSOR, ACCELEROMETER_PROPERTY_SET_WAKEUP, WAKEUP_SET);
+	if (g_cb_info[cb_number].record_chunk > 0)
+		chunk = SENSOR_RECORD_CHUNK(record->map, g_cb_info[cb_number].record_chunk);
 
-	if(state < 0)
-	{
-		ERR("ACCELEROMETER_PROPERTY_SET_WAKEUP  fail");
+	if (!chunk || chunk->sample_num == chunk->sample_max || chunk->values_num != values_num) {
+		if (record_chunk_alloc(cb_number, sample, values_num) < 0)
+			return;
+		chunk = SENSOR_RECORD_CHUNK(record->map, g_cb_info[cb_number].record_chunk);
 	}
+
+	n = chunk->sample_num;
+	SENSOR_RECORD_TIME_STAMPS(chunk)[n] = sample->time_stamp;
+	for (v = 0; v < chunk->values_num; v++)
+		SENSOR_RECORD_VALUES(chunk, v)[n] = sample->values[v];
+	SENSOR_RECORD_ACCURACY(chunk)[n] = (signed char)sample->data_accuracy;
+
+	chunk->last_ts = sample->time_stamp;
+	chunk->sample_num = n + 1;
 }
 
 
-static void sensor_changed_cb(keynode_t *node, void *data)
+static void record_detach(int cb_number)
 {
-	int event_number = (int)(data);
-	unsigned int i = 0;
-	int val;
-	int cb_number = 0;
-	sensor_event_data_t cb_data;
-	sensor_panning_data_t panning_data;
+	const int record_slot = g_cb_table[cb_number].record_slot;
 
-	if(!node)
-	{
-		ERR("Node is NULL");
+	if (record_slot < 0)
 		return;
-	}
 
-	if (vconf_keynode_get_type(node) !=  VCONF_TYPE_INT )
-	{
-		ERR("Err invaild key_type , incomming key_type : %d , key_name : %s , key_value : %d", vconf_keynode_get_type(node), vconf_keynode_get_name(node),vconf_keynode_get_int(node));
-		return;
-	}
+	g_cb_table[cb_number].record_slot = -1;
+	g_cb_info[cb_number].record_chunk = -1;
 
-	val = vconf_keynode_get_int(node);
+	if (--g_record_table[record_slot].cb_num == 0)
+		record_close(record_slot);
+}
 
-	for( i = 0 ; i < g_event_list[event_number].event_counter ; i++)
-	{
-		cb_number = g_event_list[event_number].cb_list[i];
 
-		if(g_bind_table[g_cb_table[cb_number].my_sf_handle].sensor_state ==	SENSOR_STATE_STARTED)
-		{
-			if (g_cb_table[cb_number].sensor_callback_func_t)
-			{
-				if(g_cb_table[cb_number].cb_event_type == MOTION_ENGINE_EVENT_PANNING)
-				{
-					if(val != 0)
-					{
-						panning_data.x = (short)(val >> 16);
-						panning_data.y = (short)(val & 0x0000FFFF);
-						cb_data.event_data_size = sizeof(sensor_panning_data_t);
-						cb_data.event_data = (void *)&panning_data;
-						g_cb_table[cb_number].sensor_callback_func_t(g_cb_table[cb_number].cb_event_type,&cb_data, g_cb_table[cb_number].client_data);
-					}
-				}
-				else
-				{
-					if ( val<0 )
-					{
-						ERR("vconf_keynode_get_int fail for key : %s , handle_num : %d ,get_value : %d\n",g_cb_table[cb_number].call_back_key,cb_number , val);
-						return ;
-					}
+/* SENSOR_OPTION_BUFFER_LCD_OFF : keep sampling into the rings without calling back */
+static void delivery_hold(int handle)
+{
+	int j;
+	int cb_number;
 
-					switch (g_cb_table[cb_number].cb_event_type) {
-						case ACCELEROMETER_EVENT_SET_WAKEUP :
-							/* fall through */
-						case ACCELEROMETER_EVENT_ROTATION_CHECK :
-							/* fall through */
-						case ACCELEROMETER_EVENT_SET_HORIZON :
-							/* fall through */
-						case GEOMAGNETIC_EVENT_CALIBRATION_NEEDED :
-							/* fall through */
-						case LIGHT_EVENT_CHANGE_LEVEL :
-							/* fall through */
-						case PROXIMITY_EVENT_CHANGE_STATE:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_SNAP:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_SHAKE:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_DOUBLETAP:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_TOP_TO_BOTTOM:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_DIRECT_CALL:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_TILT_TO_UNLOCK:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_LOCK_EXECUTE_CAMERA:
-							/* fall through */
-						case MOTION_ENGINE_EVENT_REACTIVE_ALERT:
-
-							cb_data.event_data_size = sizeof(val);
-							cb_data.event_data = (void *)&val;
-							g_cb_table[cb_number].sensor_callback_func_t(g_cb_table[cb_number].cb_event_type, &cb_data , g_cb_table[cb_number].client_data);
-							break;
-						default :
-							ERR("Undefined cb_event_type");
-							return ;
-							break;
-					}
+	if ( g_bind_table[handle].held ) {
+		return;
+	}
 
-					if(g_cb_table[cb_number].cb_event_type == ACCELEROMETER_EVENT_SET_WAKEUP)
-					{
-						cb_release_handle(cb_number);
-						del_cb_number(event_number, cb_number);
-					}
-				}
-			}
-			else
-			{
-				ERR("Empty Callback func in event : %x\n",g_cb_table[cb_number].cb_event_type);
-			}
-		}
-		else
-		{
-			ERR("Sensor doesn't start for event : %x",g_cb_table[cb_number].cb_event_type);
+	io_lock();
+	for ( j = 0 ; j < g_bind_info[handle].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND ; j++ ) {
+		cb_number = g_bind_info[handle].cb_slot_num[j];
+		if ( cb_number > -1 && g_cb_table[cb_number].request_data_id ) {
+			queue_account(cb_number, -(int)g_cb_table[cb_number].collected_num);
 		}
 	}
+
+	g_bind_table[handle].held = 1;
+	io_unlock();
 }
 
 
-static gboolean sensor_timeout_handler(gpointer data)
+static void delivery_release(int handle)
 {
-	int *cb_handle = (int*)(data);
-	int state;
-	sensor_event_data_t cb_data;
+	int cb_list[MAX_CB_SLOT_PER_BIND];
+	int cb_num = 0;
+	int j;
+
+	if ( !g_bind_table[handle].held ) {
+		return;
+	}
+
+	/* callbacks may unregister, so walk a copy of the subscriptions */
+	for ( j = 0 ; j < g_bind_info[handle].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND ; j++ ) {
+		if ( g_bind_info[handle].cb_slot_num[j] > -1 && g_cb_table[g_bind_info[handle].cb_slot_num[j]].request_data_id ) {
+			cb_list[cb_num++] = g_bind_info[handle].cb_slot_num[j];
+		}
+	}
 
-	if ( g_bind_table[g_cb_table[*cb_handle].my_sf_handle].sensor_state != SENSOR_STATE_STARTED ) {
-//		ERR("Check sensor_state, current sensor state : %d",g_bind_table[g_cb_table[*cb_handle].my_sf_handle].sensor_state);
-		return TRUE;
+	for ( j = 0 ; j < cb_num ; j++ ) {
+		queue_deliver_batch(cb_list[j]);
 	}
 
-	if (g_cb_table[*cb_handle].sensor_callback_func_t) {		
+	g_bind_table[handle].held = 0;
+}
 
-		if ( ((g_cb_table[*cb_handle].request_data_id & 0xFFFF) > 0) && ((g_cb_table[*cb_handle].request_data_id & 0xFFFF) < 10) ) {
-			sensor_data_t *base_data_values;
-			base_data_values =(sensor_data_t *)g_cb_table[*cb_handle].collected_data;		
 
-			if ( !base_data_values ) {
-				ERR("ERR get  saved_gather_data stuct fail in sensor_timeout_handler \n");
-				return FALSE;
-			}
-			state = sf_get_data(g_cb_table[*cb_handle].my_sf_handle, g_cb_table[*cb_handle].request_data_id, base_data_values);
-		
-			if ( state < 0 ) {
-				ERR("ERR sensor_get_struct_data fail in sensor_timeout_handler : %d\n",state);
-				return TRUE;
-			}
+static gboolean timer_source_prepare(GSource *source, gint *timeout)
+{
+	*timeout = -1;
+	return FALSE;
+}
 
-			cb_data.event_data_size = sizeof (sensor_data_t);
-			cb_data.event_data = g_cb_table[*cb_handle].collected_data;
 
-			g_cb_table[*cb_handle].sensor_callback_func_t( g_cb_table[*cb_handle].cb_event_type , &cb_data , g_cb_table[*cb_handle].client_data);
+static gboolean timer_source_check(GSource *source)
+{
+	return (g_loop_table[((loop_source_t *)source)->loop_slot].timer_pollfd.revents & G_IO_IN) ? TRUE : FALSE;
+}
 
 
-		} else {
-			ERR("Does not support data_type");
-			return TRUE;
-		}			
+static gboolean timer_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	const int loop_slot = ((loop_source_t *)source)->loop_slot;
 
-		
-	} else {
-		ERR("Empty Callback func in cb_handle : %d\n", *cb_handle);
-	}
-	
+	g_loop_table[loop_slot].wheel.run(0);
+	stream_fetch_flush(loop_slot);
 	return TRUE;
 }
 
-///////////////////////////////////for internal ///////////////////////////////////
-static int server_get_properties(int handle , unsigned int data_id, void *property_data)
+
+static GSourceFuncs g_timer_source_funcs = {
+	timer_source_prepare,
+	timer_source_check,
+	timer_source_dispatch,
+	NULL,
+};
+
+
+static void io_watch_wheel(int loop_slot)
 {
-	cpacket packet(sizeof(cmd_return_property_t) + sizeof(base_property_struct)+ 4);
-	cmd_get_property_t *cmd_payload;
-	INFO("server_get_properties called with handle : %d \n", handle);
-	if (handle < 0) {
-		ERR("Invalid handle\n");
-		errno = EINVAL;
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = loop_slot;
+
+	if(epoll_ctl(g_io_epfd, EPOLL_CTL_ADD, g_loop_table[loop_slot].wheel.get_fd(), &ev) < 0 && errno != EEXIST)
+		ERR("epoll_ctl fail , errno : %d\n", errno);
+}
+
+
+static int timer_source_attach(int loop_slot)
+{
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+
+	if(loop->timer_source)
+		return 0;
+
+	if(!loop->wheel.init()) {
+		ERR("cannot create timer wheel");
 		return -1;
 	}
 
-	cmd_payload = (cmd_get_property_t*)packet.data();
-	if (!cmd_payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
-	}	
+	loop->timer_source = g_source_new(&g_timer_source_funcs, sizeof(loop_source_t));
+	((loop_source_t *)loop->timer_source)->loop_slot = loop_slot;
+	loop->timer_pollfd.fd = loop->wheel.get_fd();
+	loop->timer_pollfd.events = G_IO_IN | G_IO_ERR;
+	loop->timer_pollfd.revents = 0;
+	g_source_attach(loop->timer_source, loop->context);
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_GET_PROPERTY);
-	packet.set_payload_size(sizeof(cmd_get_property_t));
+	/* the I/O thread runs the wheel instead of the loop, see io_thread_start() */
+	if(g_io_thread_on)
+		io_watch_wheel(loop_slot);
+	else
+		g_source_add_poll(loop->timer_source, &loop->timer_pollfd);
 
-	if(data_id)
-		cmd_payload->get_level = data_id;
+	return 0;
+}
+
+
+static gboolean delivery_source_prepare(GSource *source, gint *timeout)
+{
+	const delivery_source_t *delivery = (delivery_source_t *)source;
+
+	*timeout = -1;
+	return g_loop_table[delivery->loop_slot].delivery_pending[delivery->priority_class] ? TRUE : FALSE;
+}
+
+
+static gboolean delivery_source_check(GSource *source)
+{
+	const delivery_source_t *delivery = (delivery_source_t *)source;
+
+	return g_loop_table[delivery->loop_slot].delivery_pending[delivery->priority_class] ? TRUE : FALSE;
+}
+
+
+/*
+ * A worker runs one subscription at a time, in batches of EXEC_BATCH samples.
+ * A subscription with samples left goes back on top of the deque of the worker,
+ * where the other workers steal first, so heavy subscriptions take turns.
+ */
+static void exec_push(int worker, int cb_number, int at_top)
+{
+	exec_worker_t *w = &g_exec_worker[worker];
+
+	pthread_mutex_lock(&w->lock);
+	if (at_top)
+		w->task[--w->top & (MAX_CB_BIND_SLOT - 1)] = cb_number;
 	else
-		cmd_payload->get_level = ((unsigned int)g_bind_table[handle].sensor_type<<16) | 0x0001;
+		w->task[w->bottom++ & (MAX_CB_BIND_SLOT - 1)] = cb_number;
+	pthread_mutex_unlock(&w->lock);
+}
 
 
+static void exec_post(void)
+{
+	pthread_mutex_lock(&g_exec_lock);
+	g_exec_task_num++;
+	pthread_cond_signal(&g_exec_cond);
+	pthread_mutex_unlock(&g_exec_lock);
+}
 
-	INFO("Send CMD_GET_PROPERTY command\n");
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Faield to send a packet\n");		
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
-	}
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Faield to receive a packet\n");
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
-	}
+/* the bottom of its own deque first, then the top of the others */
+static int exec_take(int worker)
+{
+	exec_worker_t *w;
+	int cb_number = -1;
+	int i;
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			ERR("Faield to receive a packet\n");
-			release_handle(handle);
-			errno = ECOMM;
-			return -2;
+	for (i = 0; i < g_exec_worker_num && cb_number < 0; i++) {
+		w = &g_exec_worker[(worker + i) % g_exec_worker_num];
+
+		pthread_mutex_lock(&w->lock);
+		if (w->top != w->bottom) {
+			if (i == 0)
+				cb_number = w->task[--w->bottom & (MAX_CB_BIND_SLOT - 1)];
+			else
+				cb_number = w->task[w->top++ & (MAX_CB_BIND_SLOT - 1)];
 		}
+		pthread_mutex_unlock(&w->lock);
+	}
 
-		if (packet.cmd() == CMD_GET_PROPERTY) {
-			cmd_return_property_t *return_payload;
-			return_payload = (cmd_return_property_t*)packet.data();
-			if (return_payload->state < 0) {
-				ERR("sever get property fail , return state : %d\n",return_payload->state);
-				errno = EBADE;
-				return -2;
-			} else {	
-				base_property_struct *base_return_property;
-				base_return_property = (base_property_struct *)return_payload->property_struct;
-				
-				if(data_id)
-				{
-					sensor_data_properties_t *return_properties;
-					return_properties = (sensor_data_properties_t *)property_data;
-					return_properties->sensor_unit_idx = base_return_property->sensor_unit_idx ;
-					return_properties->sensor_min_range= base_return_property->sensor_min_range;
-					return_properties->sensor_max_range= base_return_property->sensor_max_range;
-					return_properties->sensor_resolution = base_return_property->sensor_resolution;				
-				}
-				else
-				{
-					sensor_properties_t *return_properties;
-					return_properties = (sensor_properties_t *)property_data;
-					return_properties->sensor_unit_idx = base_return_property->sensor_unit_idx ;
-					return_properties->sensor_min_range= base_return_property->sensor_min_range;
-					return_properties->sensor_max_range= base_return_property->sensor_max_range;
-					return_properties->sensor_resolution = base_return_property->sensor_resolution;
-					memset(return_properties->sensor_name, '\0', sizeof(return_properties->sensor_name));
-					memset(return_properties->sensor_vendor, '\0', sizeof(return_properties->sensor_vendor));
-					strncpy(return_properties->sensor_name, base_return_property->sensor_name, strlen(base_return_property->sensor_name));
-					strncpy(return_properties->sensor_vendor, base_return_property->sensor_vendor, strlen(base_return_property->sensor_vendor));
-				}
-			}
-		} else {
-			ERR("unexpected server cmd\n");
-			errno = EBADE;			
-			return -2;
-		}
+	return cb_number;
+}
+
+
+static void exec_run(int worker, int cb_number)
+{
+	exec_box_t *box = &g_exec_box[cb_number];
+	sensor_event_data_t cb_data;
+	sensor_data_t sample;
+	sensor_callback_func_t func;
+	unsigned int event_type;
+	void *client_data;
+	int requeue = 0;
+	int n;
+
+	pthread_mutex_lock(&box->lock);
+	box->state = EXEC_RUNNING;
+	box->runner = pthread_self();
+
+	for (n = 0; n < EXEC_BATCH && box->tail != box->head; n++) {
+		sample = box->sample[box->tail++ & (EXEC_BOX_SIZE - 1)];
+		func = box->func;
+		event_type = box->event_type;
+		client_data = box->client_data;
+		pthread_mutex_unlock(&box->lock);
+
+		cb_data.event_data_size = sizeof(sensor_data_t);
+		cb_data.event_data = &sample;
+		func(event_type, &cb_data, client_data);
+
+		pthread_mutex_lock(&box->lock);
 	}
 
-	return 0;
+	if (box->tail != box->head) {
+		box->state = EXEC_QUEUED;
+		exec_push(worker, cb_number, 1);
+		requeue = 1;
+	} else {
+		box->state = EXEC_IDLE;
+	}
+	pthread_cond_broadcast(&box->done);
+	pthread_mutex_unlock(&box->lock);
+
+	if (requeue)
+		exec_post();
 }
 
 
-static int server_set_property(int handle , unsigned int property_id, long value )
+static void *exec_worker_main(void *data)
 {
-	cpacket packet(sizeof(cmd_set_value_t) + 4);
-	cmd_set_value_t *cmd_payload;
-	INFO("server_set_property called with handle : %d \n", handle);
-	if (handle < 0) {
-		ERR("Invalid handle\n");
-		errno = EINVAL;
-		return -1;
-	}
+	const int worker = (int)(long)data;
+	int cb_number;
 
-	cmd_payload = (cmd_set_value_t*)packet.data();
-	if (!cmd_payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
-	}	
+	for (;;) {
+		/* a token of g_exec_task_num stands for a subscription in one of the deques */
+		pthread_mutex_lock(&g_exec_lock);
+		while (!g_exec_task_num)
+			pthread_cond_wait(&g_exec_cond, &g_exec_lock);
+		g_exec_task_num--;
+		pthread_mutex_unlock(&g_exec_lock);
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_SET_VALUE);
-	packet.set_payload_size(sizeof(cmd_set_value_t));
+		while ((cb_number = exec_take(worker)) < 0)
+			sched_yield();
 
-	cmd_payload->sensor_type = g_bind_table[handle].sensor_type;
-	cmd_payload->property = property_id;
-	cmd_payload->value = value;
+		exec_run(worker, cb_number);
+	}
 
+	return NULL;
+}
 
-	INFO("Send CMD_SET_VALUE command\n");
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Faield to send a packet\n");		
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
+
+static int exec_start(void)
+{
+	long cpu_num;
+	int i;
+
+	cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpu_num < 1)
+		cpu_num = 1;
+	if (cpu_num > EXEC_MAX_WORKER)
+		cpu_num = EXEC_MAX_WORKER;
+
+	for (i = 0; i < MAX_CB_BIND_SLOT; i++) {
+		pthread_mutex_init(&g_exec_box[i].lock, NULL);
+		pthread_cond_init(&g_exec_box[i].done, NULL);
+		g_exec_box[i].state = EXEC_IDLE;
+		g_exec_box[i].head = 0;
+		g_exec_box[i].tail = 0;
 	}
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Faield to receive a packet\n");
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
+	for (i = 0; i < EXEC_MAX_WORKER; i++) {
+		pthread_mutex_init(&g_exec_worker[i].lock, NULL);
+		g_exec_worker[i].top = 0;
+		g_exec_worker[i].bottom = 0;
 	}
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			ERR("Faield to receive a packet\n");
-			release_handle(handle);
-			errno = ECOMM;
-			return -2;
-		}
+	g_exec_worker_num = (int)cpu_num;
 
-		if (packet.cmd() == CMD_DONE) {
-			cmd_done_t *payload;
-			payload = (cmd_done_t*)packet.data();
+	for (i = 0; i < cpu_num; i++) {
+		if (pthread_create(&g_exec_worker[i].thread, NULL, exec_worker_main, (void *)(long)i) != 0)
+			break;
+		pthread_detach(g_exec_worker[i].thread);
+	}
 
-			if (payload->value == -1) {
-				ERR("cannot support input property\n");
-				errno = ENODEV;
-				return -1;
-			} 
-		} else {
-			ERR("unexpected server cmd\n");
-			errno = ECOMM;
-			return -2;
-		}
+	if (i == 0) {
+		ERR("Failed to create executor workers\n");
+		g_exec_worker_num = 0;
+		errno = EAGAIN;
+		return -1;
 	}
 
+	/* no sample was handed over yet, a short pool only narrows the home deques */
+	g_exec_worker_num = i;
+	INFO("executor started with %d workers\n", i);
+
 	return 0;
 }
 
-///////////////////////////////////for external ///////////////////////////////////
 
-EXTAPI int sf_is_sensor_event_available ( sensor_type_t desired_sensor_type , unsigned int desired_event_type )
+/* hand a sample over to the pool, the box keeps the newest EXEC_BOX_SIZE samples */
+static void exec_submit(int cb_number, const sensor_data_t *sample)
 {
-	int handle;
-	cpacket packet(sizeof(cmd_reg_t)+4);
-	cmd_reg_t *payload;
-	
-	handle = sf_connect(desired_sensor_type);
-	if ( handle < 0 ) {
-		errno = ENODEV;
-		return -2;		
-	} 
+	exec_box_t *box = &g_exec_box[cb_number];
+	int queued = 0;
+
+	pthread_mutex_lock(&box->lock);
+	if (box->head - box->tail >= EXEC_BOX_SIZE) {
+		box->tail++;
+		g_cb_info[cb_number].stats.delivered--;
+		g_cb_info[cb_number].stats.dropped++;
+	}
 
-	if ( desired_event_type != 0 ) {
+	box->sample[box->head++ & (EXEC_BOX_SIZE - 1)] = *sample;
+	box->func = g_cb_table[cb_number].sensor_callback_func_t;
+	box->event_type = g_cb_table[cb_number].cb_event_type;
+	box->client_data = g_cb_table[cb_number].client_data;
 
-		payload = (cmd_reg_t*)packet.data();
-		if (!payload) {
-			ERR("cannot find memory for send packet.data");
-			errno = ENOMEM;
-			return -2;
+	if (box->state == EXEC_IDLE) {
+		box->state = EXEC_QUEUED;
+		exec_push(cb_number % g_exec_worker_num, cb_number, 0);
+		queued = 1;
+	}
+	pthread_mutex_unlock(&box->lock);
+
+	if (queued)
+		exec_post();
+}
+
+
+/* drop the samples still in the box and wait for a running callback to return */
+static void exec_cancel(int cb_number)
+{
+	exec_box_t *box = &g_exec_box[cb_number];
+
+	if (!g_cb_table[cb_number].exec)
+		return;
+
+	/* the real-time thread submits under g_io_lock, it sees exec cleared before the box is emptied */
+	io_lock();
+	g_cb_table[cb_number].exec = 0;
+	io_unlock();
+
+	pthread_mutex_lock(&box->lock);
+	box->tail = box->head;
+	while (box->state == EXEC_RUNNING && !pthread_equal(box->runner, pthread_self()))
+		pthread_cond_wait(&box->done, &box->lock);
+	pthread_mutex_unlock(&box->lock);
+}
+
+
+/* one sample per subscription and round, so the timer source is never starved */
+static int delivery_dispatch(int loop_slot, int priority_class, int max)
+{
+	const unsigned int *pending = &g_loop_table[loop_slot].delivery_pending[priority_class];
+	sensor_event_data_t cb_data;
+	sensor_data_t sample;
+	int delivered = 0;
+	int i;
+
+	for ( i = 0 ; i < MAX_CB_BIND_SLOT && *pending && (max <= 0 || delivered < max) ; i++ ) {
+		if ( g_cb_table[i].priority != priority_class ) {
+			continue;
 		}
 
-		packet.set_version(PROTOCOL_VERSION);
-		packet.set_cmd(CMD_REG);
-		packet.set_payload_size(sizeof(cmd_reg_t));
-		payload->type = REG_CHK;
-		payload->event_type = desired_event_type;
+		if ( !g_cb_table[i].collected_num || g_bind_table[g_cb_table[i].my_sf_handle].loop_slot != loop_slot ) {
+			continue;
+		}
 
-		INFO("Send CMD_REG command\n");
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-			ERR("Faield to send a packet\n");		
-			release_handle(handle);
-			errno = ECOMM;
-			return -2;
+		if ( !g_cb_table[i].sensor_callback_func_t ) {
+			continue;
 		}
 
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-			ERR("Faield to receive a packet\n");
-			release_handle(handle);
-			errno = ECOMM;
-			return -2;
+		if ( g_bind_table[g_cb_table[i].my_sf_handle].held ) {
+			continue;
 		}
 
-		if (packet.payload_size()) {
-			if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-				ERR("Faield to receive a packet\n");
-				release_handle(handle);
-				errno = ECOMM;
-				return -2;
-			}
+		if ( !queue_pop(i, &sample) ) {
+			continue;
+		}
 
-			if (packet.cmd() == CMD_DONE) {
-				cmd_done_t *payload;
-				payload = (cmd_done_t*)packet.data();
-				if (payload->value == -1) {
-					ERR("sever check fail\n");
-					errno = ENODEV;
-					return -2;
-				} 
-			} else {
-				ERR("unexpected server cmd\n");
-				errno = ECOMM;
-				return -2;
-			}
+		g_cb_info[i].stats.delivered++;
+		delivered++;
+
+		if ( g_cb_table[i].exec ) {
+			exec_submit(i, &sample);
+			continue;
 		}
-		
-	} 
-	
-	sf_disconnect(handle);
 
-	return 0;
+		cb_data.event_data_size = sizeof (sensor_data_t);
+		cb_data.event_data = &sample;
+
+		g_cb_table[i].sensor_callback_func_t( g_cb_table[i].cb_event_type , &cb_data , g_cb_table[i].client_data);
+	}
+
+	return delivered;
 }
 
-EXTAPI int sf_get_data_properties(unsigned int data_id, sensor_data_properties_t *return_data_properties)
+
+static gboolean delivery_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
 {
-	int handle;
-	int state = -1;
-		
-	retvm_if( (!return_data_properties )  , -1 , "Invalid return properties pointer : %p", return_data_properties);
+	const delivery_source_t *delivery = (delivery_source_t *)source;
 
+	delivery_dispatch(delivery->loop_slot, delivery->priority_class, 0);
+	return TRUE;
+}
 
-	handle = sf_connect((sensor_type_t)(data_id >> 16));
-	if ( handle < 0 ) {
-		ERR("Sensor connet fail !! for : %x \n", (data_id >> 16));
-		return -1;		
-	} else {
-		state = server_get_properties( handle , data_id, return_data_properties );
-		if ( state < 0 ) {
-			ERR("server_get_properties fail , state : %d \n",state);		
-		}
-		sf_disconnect(handle);		
-	}	
 
-	return state;
-}
+static GSourceFuncs g_delivery_source_funcs = {
+	delivery_source_prepare,
+	delivery_source_check,
+	delivery_source_dispatch,
+	NULL,
+};
 
-EXTAPI int sf_get_properties(sensor_type_t sensor_type, sensor_properties_t *return_properties)
+
+static int delivery_source_attach(int loop_slot)
 {
-	int handle;
-	int state = -1;
-		
-	retvm_if( (!return_properties )  , -1 , "Invalid return properties pointer : %p", return_properties);
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	int i;
 
-	handle = sf_connect(sensor_type);
-	if ( handle < 0 ) {
-		ERR("Sensor connet fail !! for : %x \n", sensor_type);
-		return -1;		
-	} else {
-		state = server_get_properties( handle , 0, return_properties );
-		if ( state < 0 ) {
-			ERR("server_get_properties fail , state : %d \n",state);		
-		}
-		sf_disconnect(handle);		
-	}	
+	for(i = 0 ; i < SENSOR_PRIORITY_NUM ; i++) {
+		if(loop->delivery_source[i])
+			continue;
 
-	return state;
+		loop->delivery_source[i] = g_source_new(&g_delivery_source_funcs, sizeof(delivery_source_t));
+		((delivery_source_t *)loop->delivery_source[i])->loop_slot = loop_slot;
+		((delivery_source_t *)loop->delivery_source[i])->priority_class = i;
+		g_source_set_priority(loop->delivery_source[i], g_delivery_priority[i]);
+		g_source_attach(loop->delivery_source[i], loop->context);
+	}
+
+	return 0;
 }
 
 
-EXTAPI int sf_set_property(sensor_type_t sensor_type, unsigned int property_id, long value)
+static inline void io_lock(void)
 {
-	int handle;
-	int state = -1;
-		
-	handle = sf_connect(sensor_type);
-	if ( handle < 0 ) {
-		ERR("Sensor connet fail !! for : %x \n", sensor_type);
-		return -1;		
-	} else {
-		state = server_set_property( handle , property_id, value );
-		if ( state < 0 ) {
-			ERR("server_set_property fail , state : %d \n",state);		
-		}
-		sf_disconnect(handle);		
-	}	
+	if(g_io_thread_on || g_rt_thread_on)
+		pthread_mutex_lock(&g_io_lock);
+}
 
-	return state;
+
+static inline void io_unlock(void)
+{
+	if(g_io_thread_on || g_rt_thread_on)
+		pthread_mutex_unlock(&g_io_lock);
 }
 
 
-EXTAPI int sf_connect(sensor_type_t sensor_type)
+static bool io_ring_push(io_ring_t *ring, const io_record_t *record)
 {
-	register int i, j;
-	cpacket packet(sizeof(cmd_hello_t)+MAX_CHANNEL_NAME_LEN+4);	//need to check real payload size !!!
-	cmd_hello_t *payload;
-	cmd_done_t *return_payload;
-	
-	pid_t cpid;
-	size_t channel_name_length;
+	const unsigned int head = ring->head;
 
-	const char *sf_channel_name = NULL;
+	if(head - ring->tail >= IO_RING_SIZE)
+		return false;
 
-	cpid = getpid();
+	ring->record[head & (IO_RING_SIZE - 1)] = *record;
 
-	INFO("Sensor_attach_channel from pid : %d , to sensor_type : %x",cpid ,sensor_type);
-	
-	i = acquire_handle();
-	if (i == MAX_BIND_SLOT) {
-		ERR("MAX_BIND_SLOT, Too many slot required");
-		errno = ENOMEM;
-		return -2;
-	}
-	
-	INFO("Empty slot : %d\n", i);
-
-	switch (sensor_type) {
-		case ACCELEROMETER_SENSOR :
-			sf_channel_name = (char *)ACCEL_SENSOR_BASE_CHANNEL_NAME;						
-			g_bind_table[i].cb_event_max_num = 7;
-			break;
-			
-		case GEOMAGNETIC_SENSOR :
-			sf_channel_name = (char *)GEOMAG_SENSOR_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 3;
-			break;
-			
-		case LIGHT_SENSOR:
-			sf_channel_name = (char *)LIGHT_SENSOR_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 3;
-			break;
-			
-		case PROXIMITY_SENSOR:
-			sf_channel_name = (char *)PROXI_SENSOR_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 3;
-			break;
+	/* the record is complete before the consumer can see it */
+	__sync_synchronize();
+	ring->head = head + 1;
 
-		case MOTION_SENSOR:
-			sf_channel_name = (char *)MOTION_ENGINE_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 9;
-			break;
+	return true;
+}
 
-		case GYROSCOPE_SENSOR:
-			sf_channel_name = (char *)GYRO_SENSOR_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 1;
-			break;
-			
-		case THERMOMETER_SENSOR:		
-			break;
-		case BAROMETER_SENSOR:
-			sf_channel_name = (char *)BAROMETER_SENSOR_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 3;
-			break;
-		case FUSION_SENSOR:
-			sf_channel_name = (char *)FUSION_SENSOR_BASE_CHANNEL_NAME;
-			g_bind_table[i].cb_event_max_num = 3;
-			break;
 
-		case UNKNOWN_SENSOR:
-		default :
-			ERR("Undefined sensor_type");
-			release_handle(i);
-			errno = ENODEV;
-			return -2;
-			break;
-	}
+static bool io_ring_pop(io_ring_t *ring, io_record_t *record)
+{
+	const unsigned int tail = ring->tail;
 
-	g_bind_table[i].sensor_type = sensor_type ;
-	g_bind_table[i].my_handle = i;
-	g_bind_table[i].sensor_state = SENSOR_STATE_STOPPED;
-	g_bind_table[i].wakeup_state = SENSOR_WAKEUP_UNSETTED;
-	g_bind_table[i].sensor_option = SENSOR_OPTION_DEFAULT;
+	if(tail == ring->head)
+		return false;
 
-	for(j = 0 ; j < g_bind_table[i].cb_event_max_num  ; j++)
-		g_bind_table[i].cb_slot_num[j] = -1;
+	__sync_synchronize();
+	*record = ring->record[tail & (IO_RING_SIZE - 1)];
 
-	try {
-		g_bind_table[i].ipc = new csock( (char *)STR_SF_CLIENT_IPC_SOCKET, csock::SOCK_TCP|csock::SOCK_IPC|csock::SOCK_WORKER, 0, 0);
-	} catch (...) {
-		release_handle(i);
-		errno = ECOMM;
-		return -2;
-	}
+	/* the slot is read before the producer can reuse it */
+	__sync_synchronize();
+	ring->tail = tail + 1;
 
-	if (g_bind_table[i].ipc && g_bind_table[i].ipc->connect_to_server() == false) {
-		delete g_bind_table[i].ipc;
-		g_bind_table[i].ipc = NULL;
-		release_handle(i);
-		errno = ECOMM;
-		return -2;
-	}
+	return true;
+}
 
 
-	INFO("Connected to server\n");
-	payload = (cmd_hello_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
-		release_handle(i);
-		errno = ENOMEM;
-		return -2;
-	}
+/*
+ * A batch is flushed at its deadline even when its stream stops, pauses or slows down.
+ * The timer runs on the wheel of the loop, so on the I/O or real-time thread when one serves it,
+ * and the flush then goes through io_ring to the thread calling back the loop.
+ */
+static void batch_flush(int cb_number)
+{
+	/* the batch may have been closed by a sample, changed or released since the deadline */
+	if(!g_cb_table[cb_number].batch_latency || !g_cb_table[cb_number].collected_num)
+		return;
 
-	if (!sf_channel_name ) {
-		ERR("cannot find matched-sensor name!!!");
-		release_handle(i);
-		errno = ENODEV;
-		return -2;
-	} else {
-		channel_name_length = strlen(sf_channel_name);
-		if ( channel_name_length > MAX_CHANNEL_NAME_LEN  ) {
-			ERR("error, channel_name_length too long !!!");
-			release_handle(i);
-			errno = EINVAL;
-			return -1;
-		}
-	}
-	
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_HELLO);
-	packet.set_payload_size(sizeof(cmd_hello_t) + channel_name_length);
-	strcpy(payload->name, sf_channel_name);
+	if(g_bind_table[g_cb_table[cb_number].my_sf_handle].held || ctimer_wheel::now() < g_cb_table[cb_number].batch_deadline)
+		return;
 
-	if (g_bind_table[i].ipc && g_bind_table[i].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Failed to send a hello packet\n");
-		release_handle(i);
-		errno = ECOMM;
-		return -2;
-	}
+	queue_deliver_batch(cb_number);
+}
 
-	INFO("Wait for recv a reply packet\n");
-	if (g_bind_table[i].ipc && g_bind_table[i].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		release_handle(i);
-		errno = ECOMM;
-		return -2;
-	}
 
-	if (packet.payload_size()) {
-		if (g_bind_table[i].ipc && g_bind_table[i].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			release_handle(i);
-			errno = ECOMM;
-			return -2;
-		}
+static void batch_timer_expired(void *data)
+{
+	const int cb_number = (int)(long)data;
+	const int loop_slot = g_bind_table[g_cb_table[cb_number].my_sf_handle].loop_slot;
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	const unsigned long long one = 1;
+	io_record_t record;
+
+	if(!g_io_thread_on && !loop->rt) {
+		batch_flush(cb_number);
+		return;
 	}
 
-	return_payload = (cmd_done_t*)packet.data();
-	if (!return_payload) {
-		ERR("cannot find memory for return packet.data");
-		release_handle(i);
-		return -1;
-	}
+	memset(&record, 0, sizeof(record));
+	record.stream_slot = -1;
+	record.batch_cb = cb_number;
 
-	if ( return_payload->value < 0) {
-		ERR("There is no sensor \n");
-		release_handle(i);
-		return -1;
+	/* a full ring retries on the next tick */
+	if(!io_ring_push(&loop->io_ring, &record)) {
+		loop->wheel.add_at(&g_cb_table[cb_number].batch_timer, ctimer_wheel::now() + 1);
+		return;
 	}
 
-	system_off_set();
-
-	INFO("Connected sensor type : %x , handle : %d \n", sensor_type , i);	
-	return i;	
+	if(write(loop->io_notify_fd, &one, sizeof(one)) != sizeof(one))
+		ERR("write io_notify_fd fail , errno : %d\n", errno);
 }
 
-EXTAPI int sf_disconnect(int handle)
+
+static void batch_timer_arm(int cb_number)
 {
-	cpacket packet(sizeof(cmd_byebye_t)+4);
-	cmd_byebye_t *payload;
+	ctimer_wheel::entry *timer = &g_cb_table[cb_number].batch_timer;
 
-	retvm_if( handle > MAX_BIND_SLOT , -1 , "Incorrect handle");
-	retvm_if( (g_bind_table[handle].ipc == NULL) ||(handle < 0) , -1 , "sensor_detach_channel fail , invalid handle value : %d",handle);
+	timer->cb = batch_timer_expired;
+	timer->user_data = (void *)(long)cb_number;
 
-	INFO("Detach, so remove %d from the table\n", handle);
+	io_lock();
+	g_loop_table[g_bind_table[g_cb_table[cb_number].my_sf_handle].loop_slot].wheel.add_at(timer, g_cb_table[cb_number].batch_deadline);
+	io_unlock();
+}
 
-	payload = (cmd_byebye_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
-	}
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_BYEBYE);
-	packet.set_payload_size(sizeof(cmd_byebye_t));
+static void batch_timer_cancel(int cb_number)
+{
+	if(!g_cb_table[cb_number].batch_timer.is_armed())
+		return;
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Failed to send, but delete handle\n");
-		errno = ECOMM;
-		goto out;
-	}
+	io_lock();
+	g_loop_table[g_bind_table[g_cb_table[cb_number].my_sf_handle].loop_slot].wheel.cancel(&g_cb_table[cb_number].batch_timer);
+	io_unlock();
+}
 
-	INFO("Recv a reply packet\n");
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Send to reply packet fail\n");
-		errno = ECOMM;
-		goto out;
-	}
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			ERR("Failed to recv packet\n");
-			errno = ECOMM;
+/* fan the samples of the I/O thread out on the loop of their stream */
+static int io_ring_drain(int loop_slot)
+{
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	sf_stream_table_t *stream;
+	unsigned long long count;
+	io_record_t record;
+	int drained = 0;
+
+	if(read(loop->io_notify_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		ERR("read io_notify_fd fail , errno : %d\n", errno);
+
+	while(io_ring_pop(&loop->io_ring, &record)) {
+		if(record.batch_cb >= 0) {
+			if(g_bind_table[g_cb_table[record.batch_cb].my_sf_handle].loop_slot == loop_slot)
+				batch_flush(record.batch_cb);
+			continue;
 		}
+
+		stream = &g_stream_table[record.stream_slot];
+
+		/* the stream may have been released or reused since the fetch */
+		if(stream->subscriber_num == 0 || stream->data_id != record.data_id || stream->loop_slot != loop_slot)
+			continue;
+
+		stream_fanout(stream, &record.sample, record.tick);
+		drained++;
 	}
 
-out:
-	release_handle(handle);
-	system_off_unset();
-	return 0;
-	
+	return drained;
 }
 
-EXTAPI int sf_start(int handle , int option)
+
+static gboolean io_source_prepare(GSource *source, gint *timeout)
 {
-	cpacket packet(sizeof(cmd_start_t)+4);
-	cmd_start_t *payload;
+	*timeout = -1;
+	return FALSE;
+}
 
-	int lcd_state = 0;
 
-	retvm_if( handle > MAX_BIND_SLOT , -1 , "Incorrect handle");
-	retvm_if( (g_bind_table[handle].ipc == NULL) ||(handle < 0) , -1 , "sensor_start fail , invalid handle value : %d",handle);
-	retvm_if( option < 0 , -1 , "sensor_start fail , invalid option value : %d",option);
-	retvm_if( g_bind_table[handle].sensor_state == SENSOR_STATE_STARTED , 0 , "sensor already started");
+static gboolean io_source_check(GSource *source)
+{
+	return (g_loop_table[((loop_source_t *)source)->loop_slot].io_pollfd.revents & G_IO_IN) ? TRUE : FALSE;
+}
 
-	if(option != SENSOR_OPTION_ALWAYS_ON)
-	{
-		if(vconf_get_int(VCONFKEY_PM_STATE, &lcd_state) == 0)
-		{
-			if(lcd_state == VCONFKEY_PM_STATE_LCDOFF)
-			{
-				g_bind_table[handle].sensor_state = SENSOR_STATE_PAUSED;
-				DBG("SENSOR_STATE_PAUSED(LCD OFF)");
-				return 0;
-			}
-		}
-		else
-		{
-			DBG("vconf_get_int Error lcd_state = [%d]",lcd_state);
-		}
-	}
-	else
-	{
-		DBG("sensor start (SENSOR_OPTION_ALWAYS_ON)");
-	}
 
-	INFO("Sensor S/F Started\n");
+static gboolean io_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	io_ring_drain(((loop_source_t *)source)->loop_slot);
+	return TRUE;
+}
 
-	payload = (cmd_start_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
-	}
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_START);
-	packet.set_payload_size(sizeof(cmd_start_t));
-	payload->option = option;
+static GSourceFuncs g_io_source_funcs = {
+	io_source_prepare,
+	io_source_check,
+	io_source_dispatch,
+	NULL,
+};
 
-	INFO("Send CMD_START command\n");
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Faield to send a packet\n");
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
-	}
 
-	INFO("Recv a reply packet\n");
-	
-	if (g_bind_table[handle].ipc &&  g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Send to reply packet fail\n");
-		errno = ECOMM;
-		return -2;		
-	}
+static int io_source_attach(int loop_slot)
+{
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	struct epoll_event ev;
 
-	DBG("packet received\n");
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() +	packet.header_size(), packet.payload_size()) == false) {
-			errno = ECOMM;
-			return -2;
-		}
+	if(loop->io_source)
+		return 0;
 
-		if (packet.cmd() == CMD_DONE) {
-			cmd_done_t *payload;
-			payload = (cmd_done_t*)packet.data();
-			if (payload->value < 0) {
-				ERR("Error from sensor server [-1 or -2 : socket error, -3 : stopped by	sensor plugin]   value = [%d]\n", payload->value);
-				errno = ECOMM;
-				return payload->value;
-			}
-		} else {
-			ERR("unexpected server cmd\n");
-			errno = ECOMM;
-			return -2;
-		}
+	loop->io_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(loop->io_notify_fd < 0) {
+		ERR("eventfd fail , errno : %d\n", errno);
+		return -1;
 	}
 
-	g_bind_table[handle].sensor_state = SENSOR_STATE_STARTED;
-	g_bind_table[handle].sensor_option = option;
+	loop->io_ring.head = 0;
+	loop->io_ring.tail = 0;
+
+	loop->io_source = g_source_new(&g_io_source_funcs, sizeof(loop_source_t));
+	((loop_source_t *)loop->io_source)->loop_slot = loop_slot;
+	loop->io_pollfd.fd = loop->io_notify_fd;
+	loop->io_pollfd.events = G_IO_IN | G_IO_ERR;
+	loop->io_pollfd.revents = 0;
+	g_source_add_poll(loop->io_source, &loop->io_pollfd);
+	g_source_attach(loop->io_source, loop->context);
+
+	/* sf_dispatch_pending() drains the ring of the default context */
+	if(loop_slot == 0 && g_event_fd >= 0) {
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = loop->io_notify_fd;
+		if(epoll_ctl(g_event_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0)
+			ERR("epoll_ctl fail , errno : %d\n", errno);
+	}
 
 	return 0;
-
 }
 
-EXTAPI int sf_stop(int handle)
-{
-	cpacket packet(sizeof(cmd_stop_t)+4);
-	cmd_stop_t *payload;
 
-	retvm_if( handle > MAX_BIND_SLOT , -1 , "Incorrect handle");
-	retvm_if( (g_bind_table[handle].ipc == NULL) ||(handle < 0) , -1 , "sensor_stop fail , invalid handle value : %d",handle);
-	retvm_if( (g_bind_table[handle].sensor_state == SENSOR_STATE_STOPPED) || (g_bind_table[handle].sensor_state == SENSOR_STATE_PAUSED) , 0 , "sensor already stopped");
+/* NULL and the default context share slot 0, other contexts are referenced per handle */
+static int loop_acquire(GMainContext *context)
+{
+	int i;
+	int loop_slot = -1;
 
-	INFO("Sensor S/F Stopped\n");
+	if(!context || context == g_main_context_default())
+		return 0;
 
-	payload = (cmd_stop_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
+	for(i = 1 ; i < MAX_LOOP_SLOT ; i++) {
+		if(!g_loop_table[i].in_use) {
+			if(loop_slot < 0)
+				loop_slot = i;
+		} else if(g_loop_table[i].context == context) {
+			loop_slot = i;
+			break;
+		}
 	}
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_STOP);
-	packet.set_payload_size(sizeof(cmd_stop_t));
-
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Failed to send a packet\n");
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
+	if(loop_slot < 0) {
+		ERR("MAX_LOOP_SLOT, Too many main context required");
+		return -1;
 	}
 
-	g_bind_table[handle].sensor_state = SENSOR_STATE_STOPPED;
+	if(!g_loop_table[loop_slot].in_use) {
+		g_loop_table[loop_slot].in_use = 1;
+		g_loop_table[loop_slot].context = g_main_context_ref(context);
+	}
 
-	return 0;
+	g_loop_table[loop_slot].bind_num++;
 
+	return loop_slot;
 }
 
-EXTAPI int sf_register_event(int handle , unsigned int event_type ,  event_condition_t *event_condition , sensor_callback_func_t cb , void *cb_data )
+
+static void loop_release(int loop_slot)
 {
-	cpacket packet(sizeof(cmd_reg_t)+4);
-	cmd_reg_t *payload;
-	int i = 0, j = 0;
-	int avail_cb_slot_idx = -1;
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	int i;
 
-	int collect_data_flag = 0;
+	if(loop_slot <= 0 || !loop->in_use)
+		return;
 
-	retvm_if( handle > MAX_BIND_SLOT , -1 , "Incorrect handle");
-	retvm_if( (g_bind_table[handle].ipc == NULL) ||(handle < 0) , -1 , "sensor_register_cb fail , invalid handle value : %d",handle);
+	/* the real-time loop and its thread stay for the next handle */
+	if(--loop->bind_num > 0 || loop->rt)
+		return;
 
-	payload = (cmd_reg_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
+	if(loop->timer_source) {
+		g_source_destroy(loop->timer_source);
+		g_source_unref(loop->timer_source);
+		loop->timer_source = NULL;
 	}
 
-	DBG("Current handle's(%d) cb_event_max_num : %d\n", handle , g_bind_table[handle].cb_event_max_num);
-
-	for ( i=0 ; i<g_bind_table[handle].cb_event_max_num ; i++ ) {
-		if ( ((event_type&0xFFFF)>>i) == 0x0001) {
-			if (  (g_bind_table[handle].cb_slot_num[i] == -1) ||(!(g_cb_table[ g_bind_table[handle].cb_slot_num[i] ].sensor_callback_func_t))  ) {
-				DBG("Find available slot in g_bind_table for cb\n");
-				avail_cb_slot_idx = i;
+	for(i = 0 ; i < SENSOR_PRIORITY_NUM ; i++) {
+		if(loop->delivery_source[i]) {
+			g_source_destroy(loop->delivery_source[i]);
+			g_source_unref(loop->delivery_source[i]);
+			loop->delivery_source[i] = NULL;
+		}
+		loop->delivery_pending[i] = 0;
+	}
+
+	if(loop->io_source) {
+		g_source_destroy(loop->io_source);
+		g_source_unref(loop->io_source);
+		loop->io_source = NULL;
+		close(loop->io_notify_fd);
+		loop->io_notify_fd = -1;
+	}
+
+	g_main_context_unref(loop->context);
+	loop->context = NULL;
+	loop->in_use = 0;
+}
+
+
+static void stream_refresh_unlocked(int stream_slot)
+{
+	sf_stream_table_t *stream = &g_stream_table[stream_slot];
+	ctimer_wheel *wheel = &g_loop_table[stream->loop_slot].wheel;
+	unsigned int i = 0;
+	guint interval = 0;
+	guint slack = 0;
+	int active = 0;
+	int cb_number;
+
+	for(i = 0 ; i < stream->subscriber_num ; i++) {
+		cb_number = stream->subscriber_list[i];
+
+		if(!interval || g_cb_table[cb_number].gsource_interval < interval)
+			interval = g_cb_table[cb_number].gsource_interval;
+
+		if(i == 0 || g_cb_info[cb_number].tolerance < slack)
+			slack = g_cb_info[cb_number].tolerance;
+
+		if(g_bind_table[g_cb_table[cb_number].my_sf_handle].sensor_state != SENSOR_STATE_PAUSED)
+			active = 1;
+	}
+
+	if(!active)
+		interval = 0;
+
+	/* the stream is as tolerant as its strictest subscriber, and never skips a tick */
+	stream->timer.slack = (slack < interval / 2) ? slack : interval / 2;
+
+	if(stream->timer.is_armed() && stream->tick_interval == interval)
+		return;
+
+	/* retune a running stream in place : the next deadline moves relative to the last tick */
+	if(stream->timer.is_armed() && stream->tick_interval && interval) {
+		unsigned long long next = stream->deadline - stream->tick_interval + interval;
+		const unsigned long long now = ctimer_wheel::now();
+
+		if(next < now)
+			next = now;
+
+		DBG("stream [%d] for data_id [%x] retuned from %u ms to %u ms\n", stream_slot, stream->data_id, stream->tick_interval, interval);
+
+		stream->tick_interval = interval;
+		stream->deadline = next;
+		wheel->add_at(&stream->timer, next);
+		return;
+	}
+
+	wheel->cancel(&stream->timer);
+
+	stream->tick_interval = interval;
+	if(!interval)
+		return;
+
+	if(g_loop_table[stream->loop_slot].rt) {
+		if(rt_wheel_attach(stream->loop_slot) < 0)
+			return;
+	} else {
+		if(timer_source_attach(stream->loop_slot) < 0 || delivery_source_attach(stream->loop_slot) < 0)
+			return;
+
+		if(g_io_thread_on && io_source_attach(stream->loop_slot) < 0)
+			return;
+	}
+
+	DBG("stream [%d] for data_id [%x] ticks every %u ms for %u subscriber(s)\n", stream_slot, stream->data_id, interval, stream->subscriber_num);
+
+	stream->timer.cb = stream_timer_expired;
+	stream->timer.user_data = stream;
+	stream->deadline = ctimer_wheel::now() + interval;
+	wheel->add_at(&stream->timer, stream->deadline);
+}
+
+
+static void stream_refresh(int stream_slot)
+{
+	io_lock();
+	stream_refresh_unlocked(stream_slot);
+	io_unlock();
+}
+
+
+static void stream_refresh_all(void)
+{
+	int i;
+
+	for(i = 0 ; i < MAX_STREAM_SLOT ; i++) {
+		if(g_stream_table[i].subscriber_num > 0)
+			stream_refresh(i);
+	}
+}
+
+
+static int stream_add_subscriber(int cb_number)
+{
+	const unsigned int data_id = g_cb_table[cb_number].request_data_id;
+	const int loop_slot = g_bind_table[g_cb_table[cb_number].my_sf_handle].loop_slot;
+	int i;
+	int stream_slot = -1;
+
+	io_lock();
+
+	for(i = 0 ; i < MAX_STREAM_SLOT ; i++) {
+		if(g_stream_table[i].subscriber_num == 0) {
+			if(stream_slot < 0)
+				stream_slot = i;
+		} else if(g_stream_table[i].data_id == data_id && g_stream_table[i].loop_slot == loop_slot) {
+			stream_slot = i;
+			break;
+		}
+	}
+
+	if(stream_slot < 0) {
+		ERR("MAX_STREAM_SLOT, Too many stream required");
+		io_unlock();
+		return -1;
+	}
+
+	if(g_stream_table[stream_slot].subscriber_num == 0) {
+		g_stream_table[stream_slot].data_id = data_id;
+		g_stream_table[stream_slot].loop_slot = loop_slot;
+		g_stream_table[stream_slot].my_stream_slot = stream_slot;
+		g_stream_table[stream_slot].tick_interval = 0;
+	}
+
+	g_stream_table[stream_slot].subscriber_list[g_stream_table[stream_slot].subscriber_num++] = cb_number;
+	g_cb_table[cb_number].stream_slot = stream_slot;
+	g_cb_table[cb_number].elapsed_interval = 0;
+
+	stream_refresh_unlocked(stream_slot);
+
+	io_unlock();
+
+	return stream_slot;
+}
+
+
+static void stream_del_subscriber(int cb_number)
+{
+	const int stream_slot = g_cb_table[cb_number].stream_slot;
+	sf_stream_table_t *stream;
+	unsigned int i = 0, j = 0;
+
+	if(stream_slot < 0 || stream_slot >= MAX_STREAM_SLOT)
+		return;
+
+	stream = &g_stream_table[stream_slot];
+
+	io_lock();
+
+	for(i = 0 ; i < stream->subscriber_num ; i++) {
+		if(stream->subscriber_list[i] == cb_number) {
+			for(j = i ; j < stream->subscriber_num - 1 ; j++)
+				stream->subscriber_list[j] = stream->subscriber_list[j+1];
+			stream->subscriber_num--;
+			break;
+		}
+	}
+
+	g_cb_table[cb_number].stream_slot = -1;
+	g_cb_table[cb_number].elapsed_interval = 0;
+
+	stream_refresh_unlocked(stream_slot);
+
+	if(stream->subscriber_num == 0)
+		stream->data_id = 0;
+
+	io_unlock();
+}
+
+
+static void stream_align(const int *handle_list, unsigned int handle_num)
+{
+	const unsigned long long base = ctimer_wheel::now();
+	sf_stream_table_t *stream;
+	unsigned int i, j, k;
+	int match;
+
+	io_lock();
+
+	for(i = 0 ; i < MAX_STREAM_SLOT ; i++) {
+		stream = &g_stream_table[i];
+		if(stream->subscriber_num == 0 || !stream->tick_interval)
+			continue;
+
+		match = 0;
+		for(j = 0 ; j < stream->subscriber_num && !match ; j++) {
+			for(k = 0 ; k < handle_num ; k++) {
+				if(g_cb_table[stream->subscriber_list[j]].my_sf_handle == handle_list[k]) {
+					match = 1;
+					break;
+				}
+			}
+		}
+
+		if(!match)
+			continue;
+
+		for(j = 0 ; j < stream->subscriber_num ; j++)
+			g_cb_table[stream->subscriber_list[j]].elapsed_interval = 0;
+
+		stream->deadline = base + stream->tick_interval;
+		g_loop_table[stream->loop_slot].wheel.add_at(&stream->timer, stream->deadline);
+	}
+
+	io_unlock();
+}
+
+
+static void group_del_handle(int handle)
+{
+	unsigned int i, j, k;
+
+	for(i = 0 ; i < MAX_GROUP_SLOT ; i++) {
+		if(!g_group_table[i].in_use)
+			continue;
+
+		for(j = 0 ; j < g_group_table[i].handle_num ; j++) {
+			if(g_group_table[i].handle_list[j] == handle) {
+				for(k = j ; k < g_group_table[i].handle_num - 1 ; k++)
+					g_group_table[i].handle_list[k] = g_group_table[i].handle_list[k+1];
+				g_group_table[i].handle_num--;
 				break;
-			} 
+			}
+		}
+	}
+}
+
+
+inline static int handle_to_slot(int handle)
+{
+	const int slot = handle & HANDLE_SLOT_MASK;
+
+	/* a released or reused slot no longer carries this generation */
+	if (handle <= HANDLE_SLOT_MASK || slot >= MAX_BIND_SLOT)
+		return -1;
+
+	if (g_bind_table[slot].my_handle != handle)
+		return -1;
+
+	return slot;
+}
+
+
+inline static int acquire_handle(void)
+{
+	register int i;
+	unsigned int generation;
+
+	_lock.lock();
+	for (i = 0; i < MAX_BIND_SLOT; i ++) {
+		if (g_bind_table[i].my_handle <= 0) break;
+	}
+
+	if (i < MAX_BIND_SLOT) {
+		generation = (g_bind_info[i].generation + 1) & HANDLE_GEN_MASK;
+		if (!generation)
+			generation = 1;
+
+		g_bind_info[i].generation = generation;
+		g_bind_table[i].my_handle = (int)((generation << HANDLE_SLOT_BITS) | i);
+		g_bind_table[i].io_fd = -1;
+	}
+	_lock.unlock();
+
+	return i;
+}
+
+
+inline static int cb_acquire_handle(void)
+{
+	register int i;
+	_lock.lock();
+	for (i = 0; i < MAX_CB_BIND_SLOT; i ++) {
+		if (g_cb_table[i].sensor_callback_func_t == NULL) break;
+	}
+	_lock.unlock();
+
+	return i;
+}
+
+
+inline static void release_handle(int i)
+{
+	register int j;
+
+	/* a worker may still run a callback of the handle, outside of _lock and g_io_lock */
+	for (j=0; j<g_bind_info[i].cb_event_max_num && j<MAX_CB_SLOT_PER_BIND; j++) {
+		if (g_bind_info[i].cb_slot_num[j] > -1)
+			exec_cancel(g_bind_info[i].cb_slot_num[j]);
+	}
+	
+	/* the connection of the thread is a client of its own for the server */
+	bind_io_close(i);
+
+	/* g_io_lock before _lock : a callback of the real-time thread may call the API */
+	io_lock();
+	_lock.lock();
+	g_bind_table[i].my_handle = -1;
+	g_bind_table[i].reply_pending = 0;
+	g_bind_table[i].release_pending = 0;
+
+	delete g_bind_table[i].ipc;
+	g_bind_table[i].ipc = NULL;
+	g_bind_info[i].sensor_type = UNKNOWN_SENSOR;
+
+	g_bind_table[i].io_reopen = 0;
+	
+	g_bind_table[i].sensor_state = SENSOR_STATE_UNKNOWN;
+	g_bind_info[i].wakeup_state = SENSOR_WAKEUP_UNKNOWN;
+	g_bind_info[i].sensor_option = SENSOR_OPTION_DEFAULT;
+
+	for (j=0; j<g_bind_info[i].cb_event_max_num; j++) {
+		if (   (j<MAX_CB_SLOT_PER_BIND) && (g_bind_info[i].cb_slot_num[j] > -1)  ) {
+			stream_del_subscriber(g_bind_info[i].cb_slot_num[j]);
+			queue_reset(g_bind_info[i].cb_slot_num[j]);
+			record_detach(g_bind_info[i].cb_slot_num[j]);
+			del_cb_by_event_type(g_cb_table[g_bind_info[i].cb_slot_num[j]].cb_event_type, g_bind_info[i].cb_slot_num[j]);
+			g_cb_table[g_bind_info[i].cb_slot_num[j]].client_data= NULL;
+			g_cb_table[g_bind_info[i].cb_slot_num[j]].sensor_callback_func_t = NULL;
+			g_cb_table[g_bind_info[i].cb_slot_num[j]].cb_event_type = 0x00;
+			g_cb_info[g_bind_info[i].cb_slot_num[j]].my_cb_handle = -1;
+			g_bind_info[i].cb_slot_num[j] = -1;
+		}
+	}
+	
+	g_bind_info[i].cb_event_max_num = 0;
+	g_bind_table[i].held = 0;
+
+	loop_release(g_bind_table[i].loop_slot);
+	g_bind_table[i].loop_slot = 0;
+
+	group_del_handle(i);
+	
+	_lock.unlock();
+	io_unlock();
+}
+
+
+inline static void cb_release_handle(int i)
+{
+	stream_del_subscriber(i);
+	exec_cancel(i);
+
+	io_lock();
+	_lock.lock();
+	record_detach(i);
+	queue_reset(i);
+	g_cb_table[i].batch_latency = 0;
+	g_cb_table[i].adaptive_interval = 0;
+	g_cb_info[i].adaptive_next = 0;
+	g_cb_info[i].tolerance = 0;
+
+	g_cb_table[i].client_data= NULL;
+	g_cb_table[i].sensor_callback_func_t = NULL;
+	g_cb_table[i].cb_event_type = 0x00;
+	g_cb_info[i].my_cb_handle = -1;
+	g_cb_table[i].my_sf_handle = -1;
+	
+	g_cb_table[i].request_count = 0;
+	g_cb_table[i].request_data_id = 0;
+
+	g_cb_table[i].gsource_interval = 0;
+	_lock.unlock();
+	io_unlock();
+}
+
+
+void power_off_cb(keynode_t *node, void *data)
+{
+	int val = -1;
+
+	if(vconf_keynode_get_type(node) != VCONF_TYPE_INT)
+	{
+		ERR("Errer invailed keytype");
+		return;
+	}
+
+	val = vconf_keynode_get_int(node);
+
+	switch(val)
+	{
+		case SENSOR_POWEROFF_AWAKEN:
+			bind_teardown_all();
+			break;
+
+		default:
+			break;
+
+	}
+}
+
+
+void lcd_off_cb(keynode_t *node, void *data)
+{
+	int val = -1;
+
+	if(vconf_keynode_get_type(node) != VCONF_TYPE_INT)
+	{
+		ERR("Errer invailed keytype");
+		return;
+	}
+
+	val = vconf_keynode_get_int(node);
+
+	switch(val)
+	{
+		case VCONFKEY_PM_STATE_LCDOFF:   // LCD OFF
+			bind_suspend_all();
+			stream_refresh_all();
+			break;
+		case VCONFKEY_PM_STATE_NORMAL:  // LCD ON
+			bind_resume_all();
+			stream_refresh_all();
+			break;
+		default :
+			break ;
+	}
+}
+
+int system_off_set(void)
+{
+	int result = -1;
+	if(g_system_off_cb_ct == 0)
+	{
+		result = vconf_notify_key_changed(VCONFKEY_PM_STATE, lcd_off_cb, NULL);
+		if(result < 0)
+		{
+			ERR("cannot setting lcd_off_set_cb");
+		}
+		
+		result = vconf_notify_key_changed(VCONF_SF_SERVER_POWER_OFF, power_off_cb, NULL);
+		if(result < 0)
+		{
+			ERR("cannot setting power_off_set_cb");
 		}
+
+		g_system_off_cb_ct++;
+	}
+	else if (g_system_off_cb_ct > 0)
+	{
+		g_system_off_cb_ct++;
+	}
+	else
+	{
+		ERR("g_system_off_cb_ct is negative");
+		return -1;
+	}
+
+	DBG("system_off_set success");
+	return 1;
+}
+	
+int system_off_unset(void)
+{
+	int result = -1;
+	if(g_system_off_cb_ct == 1)
+	{
+		result = vconf_ignore_key_changed(VCONFKEY_PM_STATE, lcd_off_cb);
+		if(result < 0)
+		{
+			ERR("cannot setting lcd_off_set_cb");
+		}
+
+		result = vconf_ignore_key_changed(VCONF_SF_SERVER_POWER_OFF, power_off_cb);
+		if(result < 0)
+		{
+			ERR("cannot setting power_off_set_cb");
+		}
+
+		g_system_off_cb_ct = 0;
+	}
+	else if (g_system_off_cb_ct > 1)
+	{
+		g_system_off_cb_ct--;
+	}
+	else
+	{
+		ERR("g_system_off_cb_ct is negative");
+		return -1;
+	}
+	DBG("system_off_unset success");
+
+	return 1;
+}
+	
+
+void lcd_off_set_wake_up(keynode_t *node, void *data)
+{
+	int state = 0;
+
+	state = sf_set_property(ACCELEROMETER_SENSOR, ACCELEROMETER_PROPERTY_SET_WAKEUP, WAKEUP_SET);
+
+	if(state < 0)
+	{
+		ERR("ACCELEROMETER_PROPERTY_SET_WAKEUP  fail");
+	}
+}
+
+
+static void sensor_changed_cb(keynode_t *node, void *data)
+{
+	int event_number = (int)(data);
+	unsigned int i = 0;
+	int val;
+	int cb_number = 0;
+	sensor_event_data_t cb_data;
+	sensor_panning_data_t panning_data;
+	const sf_event_desc_t *desc;
+
+	if(!node)
+	{
+		ERR("Node is NULL");
+		return;
+	}
+
+	if (vconf_keynode_get_type(node) !=  VCONF_TYPE_INT )
+	{
+		ERR("Err invaild key_type , incomming key_type : %d , key_name : %s , key_value : %d", vconf_keynode_get_type(node), vconf_keynode_get_name(node),vconf_keynode_get_int(node));
+		return;
+	}
+
+	val = vconf_keynode_get_int(node);
+
+	for( i = 0 ; i < g_event_list[event_number].event_counter ; i++)
+	{
+		cb_number = g_event_list[event_number].cb_list[i];
+
+		if(g_bind_table[g_cb_table[cb_number].my_sf_handle].sensor_state ==	SENSOR_STATE_STARTED)
+		{
+			if (g_cb_table[cb_number].sensor_callback_func_t)
+			{
+				if(g_cb_table[cb_number].cb_event_type == MOTION_ENGINE_EVENT_PANNING)
+				{
+					if(val != 0)
+					{
+						panning_data.x = (short)(val >> 16);
+						panning_data.y = (short)(val & 0x0000FFFF);
+						cb_data.event_data_size = sizeof(sensor_panning_data_t);
+						cb_data.event_data = (void *)&panning_data;
+						g_cb_table[cb_number].sensor_callback_func_t(g_cb_table[cb_number].cb_event_type,&cb_data, g_cb_table[cb_number].client_data);
+					}
+				}
+				else
+				{
+					if ( val<0 )
+					{
+						ERR("vconf_keynode_get_int fail for key : %s , handle_num : %d ,get_value : %d\n",g_cb_info[cb_number].call_back_key,cb_number , val);
+						return ;
+					}
+
+					desc = event_desc(g_cb_table[cb_number].cb_event_type);
+					if ( !desc || desc->data_id ) {
+						ERR("Undefined cb_event_type");
+						return ;
+					}
+
+					cb_data.event_data_size = sizeof(val);
+					cb_data.event_data = (void *)&val;
+					g_cb_table[cb_number].sensor_callback_func_t(g_cb_table[cb_number].cb_event_type, &cb_data , g_cb_table[cb_number].client_data);
+
+					if(g_cb_table[cb_number].cb_event_type == ACCELEROMETER_EVENT_SET_WAKEUP)
+					{
+						cb_release_handle(cb_number);
+						del_cb_number(event_number, cb_number);
+					}
+				}
+			}
+			else
+			{
+				ERR("Empty Callback func in event : %x\n",g_cb_table[cb_number].cb_event_type);
+			}
+		}
+		else
+		{
+			ERR("Sensor doesn't start for event : %x",g_cb_table[cb_number].cb_event_type);
+		}
+	}
+}
+
+
+/* the retune of adaptive_update() goes to the server on the default context, owner of ipc */
+static gboolean adaptive_retune_cb(gpointer data)
+{
+	const int slot = handle_to_slot((int)(long)data);
+	int cb_number;
+	guint next;
+	int j;
+
+	if ( slot < 0 ) {
+		return FALSE;
+	}
+
+	for ( j = 0 ; j < g_bind_info[slot].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND ; j++ ) {
+		cb_number = g_bind_info[slot].cb_slot_num[j];
+		if ( cb_number < 0 || !g_cb_info[cb_number].adaptive_next ) {
+			continue;
+		}
+
+		io_lock();
+		next = g_cb_info[cb_number].adaptive_next;
+		g_cb_info[cb_number].adaptive_next = 0;
+		io_unlock();
+
+		if ( !g_cb_table[cb_number].adaptive_interval || server_post_reg(slot, g_cb_table[cb_number].cb_event_type, next) < 0 ) {
+			continue;
+		}
+
+		io_lock();
+		g_cb_table[cb_number].gsource_interval = next;
+		stream_refresh(g_cb_table[cb_number].stream_slot);
+		io_unlock();
+	}
+
+	return FALSE;
+}
+
+
+/*
+ * Adaptive ON_TIME events double their interval after ADAPTIVE_STILL_SAMPLES samples
+ * within adaptive_threshold of the reference one, up to adaptive_interval,
+ * and snap back to the asked interval on the first sample beyond it.
+ * It runs on the thread of the loop, the retune is handed to adaptive_retune_cb().
+ */
+static void adaptive_update(int cb_number, const sensor_data_t *sample)
+{
+	cb_bind_info_t *info = &g_cb_info[cb_number];
+	const guint interval = g_cb_table[cb_number].gsource_interval;
+	guint next = interval;
+	GSource *source;
+	float delta;
+	int axis_num;
+	int moved = 0;
+	int k;
+
+	axis_num = (sample->values_num < ADAPTIVE_AXIS_NUM) ? sample->values_num : ADAPTIVE_AXIS_NUM;
+
+	/* the first sample is the reference, it neither moved nor stood still */
+	if ( !info->adaptive_ref_set ) {
+		for ( k = 0 ; k < axis_num ; k++ ) {
+			info->adaptive_ref[k] = sample->values[k];
+		}
+		info->adaptive_ref_set = 1;
+		return;
+	}
+
+	for ( k = 0 ; k < axis_num ; k++ ) {
+		delta = sample->values[k] - info->adaptive_ref[k];
+		if ( delta > info->adaptive_threshold || -delta > info->adaptive_threshold ) {
+			moved = 1;
+			break;
+		}
+	}
+
+	if ( moved ) {
+		for ( k = 0 ; k < axis_num ; k++ ) {
+			info->adaptive_ref[k] = sample->values[k];
+		}
+		info->adaptive_still = 0;
+		next = info->adaptive_base;
+	} else if ( ++info->adaptive_still >= ADAPTIVE_STILL_SAMPLES ) {
+		info->adaptive_still = 0;
+		next = interval * 2;
+		if ( next > g_cb_table[cb_number].adaptive_interval ) {
+			next = g_cb_table[cb_number].adaptive_interval;
+		}
+	}
+
+	/* one retune on its way at a time, the samples after it decide the next one */
+	if ( next == interval || info->adaptive_next ) {
+		return;
+	}
+
+	DBG("adaptive cb_handle [%d] retuned from %u ms to %u ms\n", cb_number, interval, next);
+
+	info->adaptive_next = next;
+
+	source = g_idle_source_new();
+	g_source_set_priority(source, G_PRIORITY_DEFAULT);
+	g_source_set_callback(source, adaptive_retune_cb, (void *)(long)g_bind_table[g_cb_table[cb_number].my_sf_handle].my_handle, NULL);
+	g_source_attach(source, NULL);
+	g_source_unref(source);
+}
+
+
+/* lateness of a real-time tick against the expiry it was armed for */
+static void rt_account_jitter(sf_loop_table_t *loop, unsigned long long expires)
+{
+	struct timespec ts;
+	unsigned long long now_us;
+	unsigned int late_us = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now_us = ((unsigned long long)ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+
+	if ( now_us > expires * 1000ULL ) {
+		late_us = (unsigned int)(now_us - expires * 1000ULL);
+	}
+
+	loop->rt_ticks++;
+	loop->rt_jitter_sum_us += late_us;
+	if ( late_us > loop->rt_jitter_max_us ) {
+		loop->rt_jitter_max_us = late_us;
+	}
+}
+
+
+/* the first started subscriber fetches for the stream, a full SENSOR_QUEUE_BLOCK subscriber holds it back */
+static int stream_fetch_handle(sf_stream_table_t *stream)
+{
+	unsigned int i;
+	int cb_number;
+	int fetch_handle = -1;
+
+	for ( i = 0 ; i < stream->subscriber_num ; i++ ) {
+		if ( g_bind_table[g_cb_table[stream->subscriber_list[i]].my_sf_handle].sensor_state == SENSOR_STATE_STARTED ) {
+			fetch_handle = g_cb_table[stream->subscriber_list[i]].my_sf_handle;
+			break;
+		}
+	}
+
+	if ( fetch_handle < 0 ) {
+		return -1;
+	}
+
+	for ( i = 0 ; i < stream->subscriber_num ; i++ ) {
+		cb_number = stream->subscriber_list[i];
+		if ( (g_cb_table[cb_number].queue_policy == SENSOR_QUEUE_BLOCK) && queue_is_full(cb_number) ) {
+			g_cb_info[cb_number].stats.blocked++;
+			return -1;
+		}
+	}
+
+	return fetch_handle;
+}
+
+
+/* hand a sample taken for the stream to its subscribers, tick ms after the previous one */
+static void stream_fanout(sf_stream_table_t *stream, const sensor_data_t *sample, guint tick)
+{
+	const int stream_slot = stream->my_stream_slot;
+	int subscriber_list[MAX_CB_BIND_SLOT];
+	unsigned int subscriber_num;
+	unsigned int i;
+	int cb_number;
+
+	subscriber_num = stream->subscriber_num;
+	memcpy(subscriber_list, stream->subscriber_list, sizeof(int) * subscriber_num);
+
+	for ( i = 0 ; i < subscriber_num ; i++ ) {
+		cb_number = subscriber_list[i];
+
+		if ( g_cb_table[cb_number].stream_slot != stream_slot ) {
+			continue;
+		}
+
+		if ( g_bind_table[g_cb_table[cb_number].my_sf_handle].sensor_state != SENSOR_STATE_STARTED ) {
+			continue;
+		}
+
+		if ( !g_cb_table[cb_number].sensor_callback_func_t || !g_cb_table[cb_number].collected_data ) {
+			ERR("Empty Callback func in cb_handle : %d\n", cb_number);
+			continue;
+		}
+
+		g_cb_table[cb_number].elapsed_interval += tick;
+		if ( g_cb_table[cb_number].elapsed_interval < g_cb_table[cb_number].gsource_interval ) {
+			continue;
+		}
+
+		g_cb_table[cb_number].elapsed_interval -= g_cb_table[cb_number].gsource_interval;
+		if ( g_cb_table[cb_number].elapsed_interval >= g_cb_table[cb_number].gsource_interval ) {
+			g_cb_table[cb_number].elapsed_interval = 0;
+		}
+
+		if ( g_cb_table[cb_number].adaptive_interval ) {
+			adaptive_update(cb_number, sample);
+		}
+
+		if ( g_cb_table[cb_number].record_slot >= 0 ) {
+			record_sample(cb_number, sample);
+		}
+
+		queue_push(cb_number, sample);
+
+		/* the first sample of a batch starts its latency budget */
+		if ( g_cb_table[cb_number].batch_latency && !g_bind_table[g_cb_table[cb_number].my_sf_handle].held ) {
+			const unsigned long long now = ctimer_wheel::now();
+
+			if ( g_cb_table[cb_number].collected_num == 1 ) {
+				g_cb_table[cb_number].batch_deadline = now + g_cb_table[cb_number].batch_latency;
+				batch_timer_arm(cb_number);
+			}
+
+			if ( queue_is_full(cb_number) || now >= g_cb_table[cb_number].batch_deadline ) {
+				queue_deliver_batch(cb_number);
+			}
+		}
+	}
+}
+
+
+static void stream_timer_expired(void *data)
+{
+	sf_stream_table_t *stream = (sf_stream_table_t *)data;
+	sf_loop_table_t *loop = &g_loop_table[stream->loop_slot];
+	sf_fetch_t *fetch;
+	int fetch_handle;
+
+	fetch_handle = stream_fetch_handle(stream);
+
+	if ( loop->rt ) {
+		rt_account_jitter(loop, stream->timer.expires);
+	}
+
+	/* fetched with the other streams due in this run, see stream_fetch_flush() */
+	if ( fetch_handle >= 0 && (loop->rt || !g_io_thread_on || loop->io_source) && loop->fetch_num < MAX_STREAM_SLOT ) {
+		fetch = &loop->fetch[loop->fetch_num++];
+		fetch->stream_slot = stream->my_stream_slot;
+		fetch->data_id = stream->data_id;
+		fetch->handle = fetch_handle;
+		fetch->tick = stream->tick_interval;
+	}
+
+	/* keep the phase of the stream, skipping ticks that were missed entirely */
+	if ( stream->tick_interval && !stream->timer.is_armed() ) {
+		unsigned long long next = stream->deadline + stream->tick_interval;
+		const unsigned long long now = ctimer_wheel::now();
+
+		while ( next <= now ) {
+			next += stream->tick_interval;
+		}
+
+		stream->deadline = next;
+		g_loop_table[stream->loop_slot].wheel.add_at(&stream->timer, next);
+	}
+}
+
+///////////////////////////////////for internal ///////////////////////////////////
+/* Replies arrive in request order, so posted requests are settled before the next exchange */
+static int server_drain_replies(int handle)
+{
+	cpacket packet(sizeof(cmd_reg_t)+4);
+
+	while (g_bind_table[handle].reply_pending > 0) {
+		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
+			ERR("Faield to receive a packet\n");
+			release_handle(handle);
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (packet.payload_size()) {
+			if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+				ERR("Faield to receive a packet\n");
+				release_handle(handle);
+				errno = ECOMM;
+				return -2;
+			}
+
+			if (packet.cmd() == CMD_DONE) {
+				cmd_done_t *return_payload;
+				return_payload = (cmd_done_t*)packet.data();
+				if (return_payload->value == -1)
+					ERR("server rejected a posted request for handle : %d\n", handle);
+			} else {
+				ERR("unexpected server cmd\n");
+			}
+		}
+
+		g_bind_table[handle].reply_pending--;
+	}
+
+	return 0;
+}
+
+
+static bool server_get_struct_request(cpacket &packet, unsigned int data_id)
+{
+	cmd_get_data_t *payload;
+
+	payload = (cmd_get_data_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return false;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_GET_STRUCT);
+	packet.set_payload_size(sizeof(cmd_get_data_t));
+	payload->data_id = data_id;
+
+	return true;
+}
+
+
+/* Decode a CMD_GET_STRUCT reply, -1 when there is no data */
+static int server_get_struct_values(cpacket &packet, sensor_data_t *values)
+{
+	cmd_get_struct_t *return_payload;
+	base_data_struct *base_return_data;
+	struct timeval sv;	
+	int i;
+
+	return_payload = (cmd_get_struct_t*)packet.data();
+	if (!return_payload) {
+		ERR("cannot find memory for return packet.data");
+		errno = ENOMEM;
+		return -1;
+	}
+
+	if ( return_payload->state < 0 ) {
+		ERR("get values fail from server \n");
+		values->data_accuracy = SENSOR_ACCURACY_UNDEFINED;
+		values->data_unit_idx = SENSOR_UNDEFINED_UNIT;
+		values->time_stamp = 0;
+		values->values_num = 0;
+		errno = ECOMM;
+		return -1;
+	}
+
+	base_return_data = (base_data_struct *)return_payload->data_struct;
+
+	gettimeofday(&sv, NULL);
+	values->time_stamp = MICROSECONDS(sv);
+
+	values->data_accuracy = base_return_data->data_accuracy;
+	values->data_unit_idx = base_return_data->data_unit_idx;
+	values->values_num = base_return_data->values_num;
+	for ( i = 0 ; i <  base_return_data->values_num ; i++ ) {
+		values->values[i] = base_return_data->values[i];
+		DBG("client , get_data_value , [%d] : %f \n", i , values->values[i]);
+	}
+
+	return 0;
+}
+
+
+/* Read one CMD_GET_STRUCT reply, -2 when the socket failed and -1 when there is no data */
+static int server_get_struct_reply(csock *ipc, sensor_data_t *values)
+{
+	cpacket packet(sizeof(cmd_get_struct_t)+sizeof(base_data_struct)+4);
+
+	if (ipc->recv(packet.packet(), packet.header_size()) == false) {
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (packet.payload_size()) {
+		if (ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+			errno = ECOMM;
+			return -2;
+		}
+	}
+
+	return server_get_struct_values(packet, values);
+}
+
+
+/*
+ * Take one CMD_GET_STRUCT reply from the start of a receive buffer into values, see server_get_struct_reply().
+ * Returns its size, 0 while it is not complete and -1 when it does not fit a reply
+ */
+static int server_get_struct_parse(const char *buf, unsigned int len, sensor_data_t *values, int *state)
+{
+	cpacket packet(sizeof(cmd_get_struct_t)+sizeof(base_data_struct)+4);
+	const unsigned int reply_max = packet.header_size() + sizeof(cmd_get_struct_t) + sizeof(base_data_struct) + 4;
+	unsigned int size;
+
+	if (len < (unsigned int)packet.header_size())
+		return 0;
+
+	memcpy(packet.packet(), buf, packet.header_size());
+	size = packet.header_size() + packet.payload_size();
+	if (size > reply_max) {
+		errno = EPROTO;
+		return -1;
+	}
+
+	if (len < size)
+		return 0;
+
+	memcpy(packet.packet(), buf, size);
+	*state = server_get_struct_values(packet, values);
+
+	return (int)size;
+}
+
+
+/* CMD_GET_STRUCT exchange, -2 when the socket failed and -1 when there is no data */
+static int server_get_struct(csock *ipc, unsigned int data_id, sensor_data_t *values)
+{
+	cpacket packet(sizeof(cmd_get_data_t)+4);
+
+	if (!server_get_struct_request(packet, data_id))
+		return -1;
+
+	if (!ipc) {
+		errno = ECOMM;
+		return -1;
+	}
+
+	if (ipc->send(packet.packet(), packet.size()) == false) {		
+		errno = ECOMM;
+		return -2;
+	}
+
+	return server_get_struct_reply(ipc, values);
+}
+
+
+/* Send a CMD_REG without waiting, its reply is read by server_drain_replies() */
+static int server_post_reg(int handle, unsigned int event_type, unsigned int interval)
+{
+	cpacket packet(sizeof(cmd_reg_t)+4);
+	cmd_reg_t *payload;
+
+	payload = (cmd_reg_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_REG);
+	packet.set_payload_size(sizeof(cmd_reg_t));
+	payload->type = REG_ADD;
+	payload->event_type = event_type;
+	payload->interval = interval;
+
+	INFO("Post CMD_REG command with reg_type : %x , event_type : %x\n",payload->type , payload->event_type );
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Faield to send a packet\n");
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+
+	g_bind_table[handle].reply_pending++;
+
+	return 0;
+}
+
+
+static int server_get_properties(int handle , unsigned int data_id, void *property_data)
+{
+	cpacket packet(sizeof(cmd_return_property_t) + sizeof(base_property_struct)+ 4);
+	cmd_get_property_t *cmd_payload;
+	INFO("server_get_properties called with handle : %d \n", handle);
+	if (handle < 0) {
+		ERR("Invalid handle\n");
+		errno = EINVAL;
+		return -1;
+	}
+
+	cmd_payload = (cmd_get_property_t*)packet.data();
+	if (!cmd_payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}	
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_GET_PROPERTY);
+	packet.set_payload_size(sizeof(cmd_get_property_t));
+
+	if(data_id)
+		cmd_payload->get_level = data_id;
+	else
+		cmd_payload->get_level = ((unsigned int)g_bind_info[handle].sensor_type<<16) | 0x0001;
+
+
+
+	if (server_drain_replies(handle) < 0)
+		return -2;
+
+	INFO("Send CMD_GET_PROPERTY command\n");
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Faield to send a packet\n");		
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
+		ERR("Faield to receive a packet\n");
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (packet.payload_size()) {
+		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+			ERR("Faield to receive a packet\n");
+			release_handle(handle);
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (packet.cmd() == CMD_GET_PROPERTY) {
+			cmd_return_property_t *return_payload;
+			return_payload = (cmd_return_property_t*)packet.data();
+			if (return_payload->state < 0) {
+				ERR("sever get property fail , return state : %d\n",return_payload->state);
+				errno = EBADE;
+				return -2;
+			} else {	
+				base_property_struct *base_return_property;
+				base_return_property = (base_property_struct *)return_payload->property_struct;
+				
+				if(data_id)
+				{
+					sensor_data_properties_t *return_properties;
+					return_properties = (sensor_data_properties_t *)property_data;
+					return_properties->sensor_unit_idx = base_return_property->sensor_unit_idx ;
+					return_properties->sensor_min_range= base_return_property->sensor_min_range;
+					return_properties->sensor_max_range= base_return_property->sensor_max_range;
+					return_properties->sensor_resolution = base_return_property->sensor_resolution;				
+				}
+				else
+				{
+					sensor_properties_t *return_properties;
+					return_properties = (sensor_properties_t *)property_data;
+					return_properties->sensor_unit_idx = base_return_property->sensor_unit_idx ;
+					return_properties->sensor_min_range= base_return_property->sensor_min_range;
+					return_properties->sensor_max_range= base_return_property->sensor_max_range;
+					return_properties->sensor_resolution = base_return_property->sensor_resolution;
+					memset(return_properties->sensor_name, '\0', sizeof(return_properties->sensor_name));
+					memset(return_properties->sensor_vendor, '\0', sizeof(return_properties->sensor_vendor));
+					strncpy(return_properties->sensor_name, base_return_property->sensor_name, strlen(base_return_property->sensor_name));
+					strncpy(return_properties->sensor_vendor, base_return_property->sensor_vendor, strlen(base_return_property->sensor_vendor));
+				}
+			}
+		} else {
+			ERR("unexpected server cmd\n");
+			errno = EBADE;			
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+
+static int server_set_property(int handle , unsigned int property_id, long value )
+{
+	cpacket packet(sizeof(cmd_set_value_t) + 4);
+	cmd_set_value_t *cmd_payload;
+	INFO("server_set_property called with handle : %d \n", handle);
+	if (handle < 0) {
+		ERR("Invalid handle\n");
+		errno = EINVAL;
+		return -1;
+	}
+
+	cmd_payload = (cmd_set_value_t*)packet.data();
+	if (!cmd_payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}	
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_SET_VALUE);
+	packet.set_payload_size(sizeof(cmd_set_value_t));
+
+	cmd_payload->sensor_type = g_bind_info[handle].sensor_type;
+	cmd_payload->property = property_id;
+	cmd_payload->value = value;
+
+
+	if (server_drain_replies(handle) < 0)
+		return -2;
+
+	INFO("Send CMD_SET_VALUE command\n");
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Faield to send a packet\n");		
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
+		ERR("Faield to receive a packet\n");
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (packet.payload_size()) {
+		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+			ERR("Faield to receive a packet\n");
+			release_handle(handle);
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (packet.cmd() == CMD_DONE) {
+			cmd_done_t *payload;
+			payload = (cmd_done_t*)packet.data();
+
+			if (payload->value == -1) {
+				ERR("cannot support input property\n");
+				errno = ENODEV;
+				return -1;
+			} 
+		} else {
+			ERR("unexpected server cmd\n");
+			errno = ECOMM;
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+static int server_reg_events(int handle, int reg_type, const unsigned int *event_types, const unsigned int *intervals, int event_num, int *results)
+{
+	cpacket packet(sizeof(cmd_reg_t)+4);
+	cmd_reg_t *payload;
+	char *send_buf;
+	int packet_size;
+	int fail_num = 0;
+	int k;
+
+	INFO("server_reg_events called with handle : %d , reg_type : %x , event_num : %d\n", handle, reg_type, event_num);
+	if (handle < 0 || event_num <= 0) {
+		ERR("Invalid handle or event_num\n");
+		errno = EINVAL;
+		return -1;
+	}
+
+	payload = (cmd_reg_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_REG);
+	packet.set_payload_size(sizeof(cmd_reg_t));
+	packet_size = packet.size();
+
+	send_buf = (char *)malloc(packet_size * event_num);
+	if (!send_buf) {
+		ERR("cannot find memory for send_buf");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	/* Pipeline every request in one send, then collect the replies in order */
+	for (k = 0; k < event_num; k++) {
+		payload->type = reg_type;
+		payload->event_type = event_types[k];
+		payload->interval = intervals ? intervals[k] : BASE_GATHERING_INTERVAL;
+		memcpy(send_buf + (k * packet_size), packet.packet(), packet_size);
+	}
+
+	if (server_drain_replies(handle) < 0) {
+		free(send_buf);
+		return -2;
+	}
+
+	INFO("Send %d CMD_REG command(s) with reg_type : %x\n", event_num, reg_type);
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(send_buf, packet_size * event_num) == false) {
+		ERR("Faield to send a packet\n");
+		free(send_buf);
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+	free(send_buf);
+
+	for (k = 0; k < event_num; k++) {
+		results[k] = 0;
+
+		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
+			ERR("Faield to receive a packet\n");
+			release_handle(handle);
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (packet.payload_size()) {
+			if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+				ERR("Faield to receive a packet\n");
+				release_handle(handle);
+				errno = ECOMM;
+				return -2;
+			}
+
+			if (packet.cmd() == CMD_DONE) {
+				cmd_done_t *return_payload;
+				return_payload = (cmd_done_t*)packet.data();
+				if (return_payload->value == -1) {
+					ERR("server register fail for event : %x\n", event_types[k]);
+					results[k] = -1;
+					fail_num++;
+				}
+			} else {
+				ERR("unexpected server cmd\n");
+				results[k] = -1;
+				fail_num++;
+			}
+		}
+	}
+
+	if (fail_num) {
+		errno = ECOMM;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static int event_reg_prepare(int handle, unsigned int event_type, event_condition_t *event_condition, sensor_callback_func_t cb, void *cb_data, int *cb_slot_idx, unsigned int *interval)
+{
+	const sf_event_desc_t *desc;
+	int i = 0;
+	int avail_cb_slot_idx = -1;
+
+	retvm_if( !cb , -1 , "Invalid callback function for event : %x", event_type);
+
+	DBG("Current handle's(%d) cb_event_max_num : %d\n", handle , g_bind_info[handle].cb_event_max_num);
+
+	for ( i=0 ; i<g_bind_info[handle].cb_event_max_num ; i++ ) {
+		if ( ((event_type&0xFFFF)>>i) == 0x0001) {
+			if (  (g_bind_info[handle].cb_slot_num[i] == -1) ||(!(g_cb_table[ g_bind_info[handle].cb_slot_num[i] ].sensor_callback_func_t))  ) {
+				DBG("Find available slot in g_bind_table for cb\n");
+				avail_cb_slot_idx = i;
+				break;
+			}
+		}
+	}
+
+	if (avail_cb_slot_idx < 0 ) {
+		ERR("Find cb_slot fail, There is  already callback function!!\n");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	i = cb_acquire_handle();
+	if (i == MAX_CB_BIND_SLOT) {
+		ERR("MAX_BIND_SLOT, Too many slot required");
+		errno = ENOMEM;
+		return -2;
+	}
+	INFO("Empty cb_slot : %d\n", i);
+
+	g_cb_info[i].my_cb_handle = i;
+	g_cb_table[i].my_sf_handle = handle;
+	g_cb_table[i].stream_slot = -1;
+	g_cb_table[i].record_slot = -1;
+	g_cb_info[i].record_chunk = -1;
+	g_cb_table[i].priority = SENSOR_PRIORITY_DEFAULT;
+	g_cb_table[i].batch_latency = 0;
+	g_cb_table[i].adaptive_interval = 0;
+	g_cb_info[i].adaptive_next = 0;
+	g_cb_info[i].tolerance = 0;
+	g_cb_table[i].cb_event_type = event_type;
+	g_cb_table[i].client_data = cb_data;
+	g_cb_table[i].sensor_callback_func_t = cb;
+
+	memset(g_cb_info[i].call_back_key,'\0',MAX_KEY_LEN);
+	snprintf(g_cb_info[i].call_back_key,(MAX_KEY_LEN-1),"%s%x",DEFAULT_SENSOR_KEY_PREFIX, event_type);
+
+	if(!event_condition)
+		*interval = BASE_GATHERING_INTERVAL;
+	else if((event_condition->cond_op == CONDITION_EQUAL) && (event_condition->cond_value1 > 0 ))
+		*interval = event_condition->cond_value1;
+	else
+		*interval = BASE_GATHERING_INTERVAL;
+
+	desc = event_desc(event_type);
+	g_cb_table[i].request_data_id = desc ? desc->data_id : 0;
+
+	if ( g_cb_table[i].request_data_id ) {
+		if ( event_condition && ((event_condition->cond_op != CONDITION_EQUAL) || (event_condition->cond_value1 <= 0)) ) {
+			ERR("Invaild input_condition interval , input_interval : %f\n", event_condition->cond_value1);
+			cb_release_handle(i);
+			errno = EINVAL;
+			return -1;
+		}
+
+		g_cb_table[i].gsource_interval = (guint)(*interval);
+		if ( g_cb_table[i].gsource_interval == 0 ) {
+			ERR("Error , gsource_interval value : %u",g_cb_table[i].gsource_interval);
+			cb_release_handle(i);
+			errno = EINVAL;
+			return -1;
+		}
+
+		memset(&g_cb_info[i].stats, 0, sizeof(sensor_event_stats_t));
+		if ( queue_alloc(i, ON_TIME_REQUEST_COUNTER, SENSOR_QUEUE_DROP_OLDEST) < 0 ) {
+			cb_release_handle(i);
+			errno = ENOMEM;
+			return -2;
+		}
+	} else {
+		g_cb_table[i].request_count = 0;
+		g_cb_table[i].collected_data = NULL;
+	}
+
+	*cb_slot_idx = avail_cb_slot_idx;
+
+	return i;
+}
+
+
+static int event_reg_commit(int handle, int cb_number, int cb_slot_idx)
+{
+	int j = 0;
+	const sf_event_desc_t *desc;
+
+	INFO("key : %s(p:%p), cb_handle value : %d\n", g_cb_info[cb_number].call_back_key ,g_cb_info[cb_number].call_back_key, cb_number );
+
+	if ( g_cb_table[cb_number].request_data_id ) {
+		if ( stream_add_subscriber(cb_number) < 0 ) {
+			ERR("cannot attach cb_handle : %d to a fetch stream for data_id : %x\n", cb_number, g_cb_table[cb_number].request_data_id);
+			cb_release_handle(cb_number);
+			errno = ENOMEM;
+			return -2;
+		}
+	} else {
+		desc = event_desc(g_cb_table[cb_number].cb_event_type);
+		j = desc ? desc->list_slot : -1;
+		if(j >= 0) {
+			if(g_event_list[j].event_counter < 1){
+				if(vconf_notify_key_changed(g_cb_info[cb_number].call_back_key,sensor_changed_cb,(void*)(j)) == 0 ) {
+					DBG("vconf_add_chaged_cb success for key : %s  , my_cb_handle value : %d\n", g_cb_info[cb_number].call_back_key, g_cb_info[cb_number].my_cb_handle);
+				} else {
+					DBG("vconf_add_chaged_cb fail for key : %s  , my_cb_handle value : %d\n", g_cb_info[cb_number].call_back_key, g_cb_info[cb_number].my_cb_handle);
+					cb_release_handle(cb_number);
+					errno = ENODEV;
+					return -2;
+				}
+			}else {
+				DBG("vconf_add_changed_cb is already registered for key : %s, my_cb_handle	value : %d\n", g_cb_info[cb_number].call_back_key,	g_cb_info[cb_number].my_cb_handle);
+			}
+			add_cb_number(j, cb_number);
+		}
+	}
+
+	g_bind_info[handle].cb_slot_num[cb_slot_idx] = cb_number;
+
+	return 0;
+}
+
+
+static int event_find_cb_slot(int handle, unsigned int event_type)
+{
+	int i;
+
+	for ( i=0 ; i<g_bind_info[handle].cb_event_max_num ; i++ ) {
+		if (  g_bind_info[handle].cb_slot_num[i] != -1 ) {
+			if ( event_type == g_cb_table[ g_bind_info[handle].cb_slot_num[i] ].cb_event_type) {
+				return i;
+			}
+		}
+	}
+
+	return -1;
+}
+
+
+static int event_unreg_release(int handle, int cb_slot_idx)
+{
+	const int cb_number = g_bind_info[handle].cb_slot_num[cb_slot_idx];
+	const unsigned int event_type = g_cb_table[cb_number].cb_event_type;
+	int state = 0;
+	const sf_event_desc_t *desc;
+	int j = 0;
+
+	if ( g_cb_table[cb_number].request_data_id ) {
+		io_lock();
+		stream_del_subscriber(cb_number);
+		g_cb_table[cb_number].request_count = 0;
+		g_cb_table[cb_number].request_data_id = 0;
+		g_cb_table[cb_number].gsource_interval = 0;
+		io_unlock();
+	} else {
+		desc = event_desc(event_type);
+		j = desc ? desc->list_slot : -1;
+		if(j >= 0) {
+			if(g_event_list[j].event_counter <= 1){
+				state = vconf_ignore_key_changed(g_cb_info[cb_number].call_back_key, sensor_changed_cb);
+				if ( state < 0 ) {
+					ERR("Failed to del callback using by vconf_del_changed_cb for key : %s\n",g_cb_info[cb_number].call_back_key);
+					errno = ENODEV;
+					state = -2;
+				}
+				else {
+					DBG("del callback using by vconf success");
+				}
+			} else {
+				DBG("fake remove");
+			}
+			del_cb_number(j,cb_number);
+		}
+	}
+
+	cb_release_handle(cb_number);
+	g_bind_info[handle].cb_slot_num[cb_slot_idx] = -1;
+
+	return state;
+}
+
+
+static int server_send_start(int handle, int option)
+{
+	cpacket packet(sizeof(cmd_start_t)+4);
+	cmd_start_t *payload;
+
+	payload = (cmd_start_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_START);
+	packet.set_payload_size(sizeof(cmd_start_t));
+	payload->option = option;
+
+	if (server_drain_replies(handle) < 0)
+		return -2;
+
+	INFO("Send CMD_START command\n");
+	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Faield to send a packet\n");
+		release_handle(handle);
+		errno = ECOMM;
+		return -2;
+	}
+
+	return 0;
+}
+
+
+static int server_recv_start(int handle)
+{
+	cpacket packet(sizeof(cmd_start_t)+4);
+
+	INFO("Recv a reply packet\n");
+
+	if (g_bind_table[handle].ipc &&  g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
+		ERR("Send to reply packet fail\n");
+		errno = ECOMM;
+		return -2;
+	}
+
+	DBG("packet received\n");
+	if (packet.payload_size()) {
+		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() +	packet.header_size(), packet.payload_size()) == false) {
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (packet.cmd() == CMD_DONE) {
+			cmd_done_t *payload;
+			payload = (cmd_done_t*)packet.data();
+			if (payload->value < 0) {
+				ERR("Error from sensor server [-1 or -2 : socket error, -3 : stopped by	sensor plugin]   value = [%d]\n", payload->value);
+				errno = ECOMM;
+				return payload->value;
+			}
+		} else {
+			ERR("unexpected server cmd\n");
+			errno = ECOMM;
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+ * Screen and power transitions of every connection at once.
+ * The server has no compound command, so each connection gets its requests
+ * back to back in a single send, and replies are only read once every
+ * connection has been sent to : the whole transition costs one round trip.
+ */
+static void bind_suspend_all(void)
+{
+	int i;
+
+	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
+	{
+		if(g_bind_table[i].ipc == NULL)
+			continue;
+
+		if(g_bind_info[i].sensor_option == SENSOR_OPTION_BUFFER_LCD_OFF && g_bind_table[i].sensor_state == SENSOR_STATE_STARTED)
+		{
+			delivery_hold(i);
+			DBG("LCD OFF and sensor handle [%d] buffering",i);
+			continue;
+		}
+
+		if(g_bind_info[i].wakeup_state == SENSOR_WAKEUP_SETTED || g_bind_info[i].sensor_option == SENSOR_OPTION_ALWAYS_ON)
+			continue;
+
+		/* CMD_STOP has no reply, so it never waits */
+		if(g_bind_table[i].sensor_state == SENSOR_STATE_STARTED)
+		{
+			if(sf_stop(g_bind_table[i].my_handle) < 0)
+				ERR("Cannot stop handle [%d]",i);
+			else {
+				io_lock();
+				g_bind_table[i].sensor_state = SENSOR_STATE_PAUSED;
+				io_unlock();
+			}
+		}
+		DBG("LCD OFF and sensor handle [%d] stopped",i);
+	}
+}
+
+
+/* LCD on is notified on the default context, held callbacks belong to the context of their handle */
+static gboolean delivery_release_cb(gpointer data)
+{
+	const int slot = handle_to_slot((int)(long)data);
+
+	if (slot >= 0)
+		delivery_release(slot);
+
+	return FALSE;
+}
+
+
+static void bind_resume_all(void)
+{
+	const unsigned long long one = 1;
+	int sent[MAX_BIND_SLOT];
+	int option;
+	int i;
+
+	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
+	{
+		sent[i] = 0;
+
+		if(g_bind_table[i].held && g_loop_table[g_bind_table[i].loop_slot].rt)
+		{
+			io_lock();
+			g_bind_table[i].release_pending = 1;
+			io_unlock();
+
+			if(write(g_loop_table[g_bind_table[i].loop_slot].io_notify_fd, &one, sizeof(one)) != sizeof(one))
+				ERR("write io_notify_fd fail , errno : %d\n", errno);
+			DBG("LCD ON and sensor handle [%d] buffer passed to the real-time thread",i);
+		}
+		else if(g_bind_table[i].held && g_bind_table[i].loop_slot)
+		{
+			g_main_context_invoke(g_loop_table[g_bind_table[i].loop_slot].context, delivery_release_cb, (void *)(long)g_bind_table[i].my_handle);
+			DBG("LCD ON and sensor handle [%d] buffer passed to its context",i);
+		}
+		else if(g_bind_table[i].held)
+		{
+			delivery_release(i);
+			DBG("LCD ON and sensor handle [%d] buffer delivered",i);
+		}
+
+		if(g_bind_table[i].ipc == NULL || g_bind_table[i].sensor_state != SENSOR_STATE_PAUSED)
+			continue;
+
+		option = g_bind_info[i].sensor_option;
+		if(server_send_start(i, (option == SENSOR_OPTION_BUFFER_LCD_OFF) ? SENSOR_OPTION_ALWAYS_ON : option) < 0)
+		{
+			ERR("Cannot start handle [%d]",i);
+			continue;
+		}
+		sent[i] = 1;
+	}
+
+	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
+	{
+		if(!sent[i])
+			continue;
+
+		if(server_recv_start(i) < 0)
+		{
+			ERR("Cannot start handle [%d]",i);
+			continue;
+		}
+
+		io_lock();
+		g_bind_table[i].sensor_state = SENSOR_STATE_STARTED;
+		io_unlock();
+
+		bind_io_sync(i);
+		DBG("LCD ON and sensor handle [%d] started",i);
+	}
+}
+
+
+static void bind_teardown_all(void)
+{
+	cpacket stop_packet(sizeof(cmd_stop_t)+4);
+	cpacket reg_packet(sizeof(cmd_reg_t)+4);
+	cpacket bye_packet(sizeof(cmd_byebye_t)+4);
+	cpacket reply_packet(sizeof(cmd_reg_t)+4);
+	cmd_reg_t *reg_payload;
+	int reply_num[MAX_BIND_SLOT];
+	char *send_buf;
+	int send_size;
+	int cb_number;
+	int i, j, k;
+
+	reg_payload = (cmd_reg_t*)reg_packet.data();
+	if (!stop_packet.data() || !reg_payload || !bye_packet.data()) {
+		ERR("cannot find memory for send packet.data");
+		return;
+	}
+
+	stop_packet.set_version(PROTOCOL_VERSION);
+	stop_packet.set_cmd(CMD_STOP);
+	stop_packet.set_payload_size(sizeof(cmd_stop_t));
+
+	reg_packet.set_version(PROTOCOL_VERSION);
+	reg_packet.set_cmd(CMD_REG);
+	reg_packet.set_payload_size(sizeof(cmd_reg_t));
+	reg_payload->type = REG_DEL;
+	reg_payload->interval = BASE_GATHERING_INTERVAL;
+
+	bye_packet.set_version(PROTOCOL_VERSION);
+	bye_packet.set_cmd(CMD_BYEBYE);
+	bye_packet.set_payload_size(sizeof(cmd_byebye_t));
+
+	send_buf = (char *)malloc(stop_packet.size() + (reg_packet.size() * MAX_CB_SLOT_PER_BIND) + bye_packet.size());
+	if (!send_buf) {
+		ERR("cannot find memory for send_buf");
+		return;
+	}
+
+	/* stop, unregister every event and say bye in one send per connection */
+	for (i = 0; i < MAX_BIND_SLOT; i++) {
+		reply_num[i] = 0;
+
+		if (g_bind_table[i].ipc == NULL)
+			continue;
+
+		if (server_drain_replies(i) < 0)
+			continue;
+
+		send_size = 0;
+
+		if (g_bind_table[i].sensor_state == SENSOR_STATE_STARTED) {
+			memcpy(send_buf + send_size, stop_packet.packet(), stop_packet.size());
+			send_size += stop_packet.size();
+		}
+
+		for (j = 0; j < g_bind_info[i].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND; j++) {
+			cb_number = g_bind_info[i].cb_slot_num[j];
+			if (cb_number < 0)
+				continue;
+
+			reg_payload->event_type = g_cb_table[cb_number].cb_event_type;
+			memcpy(send_buf + send_size, reg_packet.packet(), reg_packet.size());
+			send_size += reg_packet.size();
+			reply_num[i]++;
+		}
+
+		memcpy(send_buf + send_size, bye_packet.packet(), bye_packet.size());
+		send_size += bye_packet.size();
+		reply_num[i]++;
+
+		if (g_bind_table[i].ipc->send(send_buf, send_size) == false) {
+			ERR("Failed to send teardown of handle [%d], but delete handle\n", i);
+			reply_num[i] = 0;
+		}
+	}
+
+	free(send_buf);
+
+	for (i = 0; i < MAX_BIND_SLOT; i++) {
+		if (g_bind_table[i].ipc == NULL)
+			continue;
+
+		for (k = 0; k < reply_num[i]; k++) {
+			if (g_bind_table[i].ipc->recv(reply_packet.packet(), reply_packet.header_size()) == false)
+				break;
+
+			if (reply_packet.payload_size() &&
+				g_bind_table[i].ipc->recv((char*)reply_packet.packet() + reply_packet.header_size(), reply_packet.payload_size()) == false)
+				break;
+		}
+
+		for (j = 0; j < g_bind_info[i].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND; j++) {
+			if (g_bind_info[i].cb_slot_num[j] > -1)
+				event_unreg_release(i, j);
+		}
+
+		DBG("Power off and sensor handle [%d] released\n", i);
+		release_handle(i);
+		system_off_unset();
+	}
+}
+
+
+///////////////////////////////////for external ///////////////////////////////////
+
+EXTAPI int sf_is_sensor_event_available ( sensor_type_t desired_sensor_type , unsigned int desired_event_type )
+{
+	int handle;
+	int slot;
+	cpacket packet(sizeof(cmd_reg_t)+4);
+	cmd_reg_t *payload;
+	
+	handle = sf_connect(desired_sensor_type);
+	if ( handle < 0 ) {
+		errno = ENODEV;
+		return -2;		
+	} 
+
+	slot = handle_to_slot(handle);
+
+	if ( desired_event_type != 0 ) {
+
+		payload = (cmd_reg_t*)packet.data();
+		if (!payload) {
+			ERR("cannot find memory for send packet.data");
+			errno = ENOMEM;
+			return -2;
+		}
+
+		packet.set_version(PROTOCOL_VERSION);
+		packet.set_cmd(CMD_REG);
+		packet.set_payload_size(sizeof(cmd_reg_t));
+		payload->type = REG_CHK;
+		payload->event_type = desired_event_type;
+
+		INFO("Send CMD_REG command\n");
+		if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->send(packet.packet(), packet.size()) == false) {
+			ERR("Faield to send a packet\n");		
+			release_handle(slot);
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->recv(packet.packet(), packet.header_size()) == false) {
+			ERR("Faield to receive a packet\n");
+			release_handle(slot);
+			errno = ECOMM;
+			return -2;
+		}
+
+		if (packet.payload_size()) {
+			if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+				ERR("Faield to receive a packet\n");
+				release_handle(slot);
+				errno = ECOMM;
+				return -2;
+			}
+
+			if (packet.cmd() == CMD_DONE) {
+				cmd_done_t *payload;
+				payload = (cmd_done_t*)packet.data();
+				if (payload->value == -1) {
+					ERR("sever check fail\n");
+					errno = ENODEV;
+					return -2;
+				} 
+			} else {
+				ERR("unexpected server cmd\n");
+				errno = ECOMM;
+				return -2;
+			}
+		}
+		
+	} 
+	
+	sf_disconnect(handle);
+
+	return 0;
+}
+
+EXTAPI int sf_get_data_properties(unsigned int data_id, sensor_data_properties_t *return_data_properties)
+{
+	int handle;
+	int state = -1;
+		
+	retvm_if( (!return_data_properties )  , -1 , "Invalid return properties pointer : %p", return_data_properties);
+
+
+	handle = sf_connect((sensor_type_t)(data_id >> 16));
+	if ( handle < 0 ) {
+		ERR("Sensor connet fail !! for : %x \n", (data_id >> 16));
+		return -1;		
+	} else {
+		state = server_get_properties( handle_to_slot(handle) , data_id, return_data_properties );
+		if ( state < 0 ) {
+			ERR("server_get_properties fail , state : %d \n",state);		
+		}
+		sf_disconnect(handle);		
+	}	
+
+	return state;
+}
+
+EXTAPI int sf_get_properties(sensor_type_t sensor_type, sensor_properties_t *return_properties)
+{
+	int handle;
+	int state = -1;
+		
+	retvm_if( (!return_properties )  , -1 , "Invalid return properties pointer : %p", return_properties);
+
+	handle = sf_connect(sensor_type);
+	if ( handle < 0 ) {
+		ERR("Sensor connet fail !! for : %x \n", sensor_type);
+		return -1;		
+	} else {
+		state = server_get_properties( handle_to_slot(handle) , 0, return_properties );
+		if ( state < 0 ) {
+			ERR("server_get_properties fail , state : %d \n",state);		
+		}
+		sf_disconnect(handle);		
+	}	
+
+	return state;
+}
+
+
+EXTAPI int sf_set_property(sensor_type_t sensor_type, unsigned int property_id, long value)
+{
+	int handle;
+	int state = -1;
+		
+	handle = sf_connect(sensor_type);
+	if ( handle < 0 ) {
+		ERR("Sensor connet fail !! for : %x \n", sensor_type);
+		return -1;		
+	} else {
+		state = server_set_property( handle_to_slot(handle) , property_id, value );
+		if ( state < 0 ) {
+			ERR("server_set_property fail , state : %d \n",state);		
+		}
+		sf_disconnect(handle);		
+	}	
+
+	return state;
+}
+
+
+/*
+ * sf_connect() in two steps : bind_prepare() reserves and fills a bind slot,
+ * bind_hello() opens the socket and says hello to the server.
+ * bind_hello() touches no table, so sf_connect_async() runs it on a thread.
+ */
+static int bind_prepare(sensor_type_t sensor_type, const char **channel_name)
+{
+	register int i, j;
+	const char *sf_channel_name = NULL;
+	const sf_sensor_desc_t *desc;
+
+	i = acquire_handle();
+	if (i == MAX_BIND_SLOT) {
+		ERR("MAX_BIND_SLOT, Too many slot required");
+		errno = ENOMEM;
+		return -2;
+	}
+	
+	INFO("Empty slot : %d\n", i);
+
+	desc = sensor_desc(sensor_type);
+	if (!desc) {
+		ERR("cannot find matched-sensor name!!!");
+		release_handle(i);
+		errno = ENODEV;
+		return -2;
+	}
+
+	sf_channel_name = desc->channel_name;
+	g_bind_info[i].cb_event_max_num = desc->event_num;
+
+	if ( strlen(sf_channel_name) > MAX_CHANNEL_NAME_LEN  ) {
+		ERR("error, channel_name_length too long !!!");
+		release_handle(i);
+		errno = EINVAL;
+		return -1;
+	}
+
+	g_bind_info[i].sensor_type = sensor_type ;
+	g_bind_table[i].sensor_state = SENSOR_STATE_STOPPED;
+	g_bind_info[i].wakeup_state = SENSOR_WAKEUP_UNSETTED;
+	g_bind_info[i].sensor_option = SENSOR_OPTION_DEFAULT;
+
+	for(j = 0 ; j < g_bind_info[i].cb_event_max_num  ; j++)
+		g_bind_info[i].cb_slot_num[j] = -1;
+
+	g_bind_info[i].channel_name = sf_channel_name;
+	*channel_name = sf_channel_name;
+	return i;
+}
+
+
+static int bind_hello(csock **ipc_out, const char *sf_channel_name)
+{
+	cpacket packet(sizeof(cmd_hello_t)+MAX_CHANNEL_NAME_LEN+4);	//need to check real payload size !!!
+	cmd_hello_t *payload;
+	cmd_done_t *return_payload;
+	csock *ipc;
+	size_t channel_name_length;
+
+	try {
+		ipc = new csock( (char *)STR_SF_CLIENT_IPC_SOCKET, csock::SOCK_TCP|csock::SOCK_IPC|csock::SOCK_WORKER, 0, 0);
+	} catch (...) {
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (ipc->connect_to_server() == false) {
+		delete ipc;
+		errno = ECOMM;
+		return -2;
+	}
+
+	INFO("Connected to server\n");
+	payload = (cmd_hello_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		delete ipc;
+		errno = ENOMEM;
+		return -2;
+	}
+
+	channel_name_length = strlen(sf_channel_name);
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_HELLO);
+	packet.set_payload_size(sizeof(cmd_hello_t) + channel_name_length);
+	strcpy(payload->name, sf_channel_name);
+
+	if (ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Failed to send a hello packet\n");
+		delete ipc;
+		errno = ECOMM;
+		return -2;
+	}
+
+	INFO("Wait for recv a reply packet\n");
+	if (ipc->recv(packet.packet(), packet.header_size()) == false) {
+		delete ipc;
+		errno = ECOMM;
+		return -2;
+	}
+
+	if (packet.payload_size()) {
+		if (ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+			delete ipc;
+			errno = ECOMM;
+			return -2;
+		}
+	}
+
+	return_payload = (cmd_done_t*)packet.data();
+	if (!return_payload) {
+		ERR("cannot find memory for return packet.data");
+		delete ipc;
+		errno = ENOMEM;
+		return -1;
+	}
+
+	if ( return_payload->value < 0) {
+		ERR("There is no sensor \n");
+		delete ipc;
+		errno = ENODEV;
+		return -1;
+	}
+
+	*ipc_out = ipc;
+	return 0;
+}
+
+
+static bool fd_send_all(int fd, const char *buf, unsigned int len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = send(fd, buf, len, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+
+static bool fd_recv_all(int fd, char *buf, unsigned int len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = recv(fd, buf, len, 0);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+
+/*
+ * bind_hello() on a plain AF_UNIX socket, for io_fd which io_uring serves with the descriptor
+ * csock keeps to itself. Returns the connected socket, -2 when it cannot reach the server
+ * and -1 when the server refused the channel
+ */
+static int bind_hello_fd(const char *sf_channel_name)
+{
+	cpacket packet(sizeof(cmd_hello_t)+MAX_CHANNEL_NAME_LEN+4);
+	cmd_hello_t *payload;
+	cmd_done_t *return_payload;
+	struct sockaddr_un addr;
+	int fd;
+
+	payload = (cmd_hello_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		ERR("socket fail , errno : %d\n", errno);
+		errno = ECOMM;
+		return -2;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, STR_SF_CLIENT_IPC_SOCKET, sizeof(addr.sun_path) - 1);
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		errno = ECOMM;
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_HELLO);
+	packet.set_payload_size(sizeof(cmd_hello_t) + strlen(sf_channel_name));
+	strcpy(payload->name, sf_channel_name);
+
+	if (!fd_send_all(fd, (const char *)packet.packet(), packet.size())
+		|| !fd_recv_all(fd, (char *)packet.packet(), packet.header_size())
+		|| (packet.payload_size() && !fd_recv_all(fd, (char *)packet.packet() + packet.header_size(), packet.payload_size()))) {
+		ERR("Failed to exchange a hello packet\n");
+		close(fd);
+		errno = ECOMM;
+		return -2;
+	}
+
+	return_payload = (cmd_done_t*)packet.data();
+	if (!return_payload || return_payload->value < 0) {
+		ERR("There is no sensor \n");
+		close(fd);
+		errno = ENODEV;
+		return -1;
+	}
+
+	return fd;
+}
+
+
+/*
+ * The I/O and the real-time thread fetch samples on io_fd, a connection of their own
+ * which the server counts as one more client of the handle : it is opened started
+ * while the handle is started on a loop of either thread, and closed with CMD_BYEBYE.
+ * It is a plain socket, so that io_uring can serve it, see stream_fetch_uring().
+ * Opening and closing block, so they run on the thread of the API, never from a tick,
+ * and the thread only sees io_fd set or cleared under g_io_lock.
+ */
+static int bind_io_open(int slot)
+{
+	cpacket packet(sizeof(cmd_start_t)+4);
+	cmd_start_t *payload;
+	cmd_done_t *return_payload;
+	int fd;
+
+	payload = (cmd_start_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	fd = bind_hello_fd(g_bind_info[slot].channel_name);
+	if (fd < 0) {
+		ERR("cannot open I/O connection of handle [%d]\n", slot);
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_START);
+	packet.set_payload_size(sizeof(cmd_start_t));
+	payload->option = (g_bind_info[slot].sensor_option == SENSOR_OPTION_BUFFER_LCD_OFF) ? SENSOR_OPTION_ALWAYS_ON : g_bind_info[slot].sensor_option;
+
+	if (!fd_send_all(fd, (const char *)packet.packet(), packet.size())
+		|| !fd_recv_all(fd, (char *)packet.packet(), packet.header_size())
+		|| (packet.payload_size() && !fd_recv_all(fd, (char *)packet.packet() + packet.header_size(), packet.payload_size()))) {
+		ERR("cannot start I/O connection of handle [%d]\n", slot);
+		close(fd);
+		errno = ECOMM;
+		return -2;
+	}
+
+	return_payload = (cmd_done_t*)packet.data();
+	if (packet.payload_size() && packet.cmd() == CMD_DONE && return_payload->value < 0) {
+		ERR("server refused to start I/O connection of handle [%d] , value : %d\n", slot, return_payload->value);
+		close(fd);
+		errno = ECOMM;
+		return -2;
+	}
+
+	io_lock();
+	g_bind_table[slot].io_fd = fd;
+	io_unlock();
+
+	return 0;
+}
+
+
+/* stop and bye in one send, like bind_teardown_all() does on ipc */
+static void bind_io_close(int slot)
+{
+	cpacket stop_packet(sizeof(cmd_stop_t)+4);
+	cpacket bye_packet(sizeof(cmd_byebye_t)+4);
+	char *send_buf;
+	int fd;
+
+	io_lock();
+	fd = g_bind_table[slot].io_fd;
+	g_bind_table[slot].io_fd = -1;
+	io_unlock();
+
+	if (fd < 0)
+		return;
+
+	send_buf = (char *)malloc(stop_packet.size() + bye_packet.size());
+	if (!send_buf || !stop_packet.data() || !bye_packet.data()) {
+		ERR("cannot find memory for send_buf");
+		free(send_buf);
+		close(fd);
+		return;
+	}
+
+	stop_packet.set_version(PROTOCOL_VERSION);
+	stop_packet.set_cmd(CMD_STOP);
+	stop_packet.set_payload_size(sizeof(cmd_stop_t));
+
+	bye_packet.set_version(PROTOCOL_VERSION);
+	bye_packet.set_cmd(CMD_BYEBYE);
+	bye_packet.set_payload_size(sizeof(cmd_byebye_t));
+
+	memcpy(send_buf, stop_packet.packet(), stop_packet.size());
+	memcpy(send_buf + stop_packet.size(), bye_packet.packet(), bye_packet.size());
+
+	/* CMD_STOP has no reply, the one read is of CMD_BYEBYE */
+	if (!fd_send_all(fd, send_buf, stop_packet.size() + bye_packet.size())
+		|| !fd_recv_all(fd, (char *)bye_packet.packet(), bye_packet.header_size())
+		|| (bye_packet.payload_size() && !fd_recv_all(fd, (char *)bye_packet.packet() + bye_packet.header_size(), bye_packet.payload_size())))
+		ERR("Failed to close I/O connection of handle [%d], but delete it\n", slot);
+
+	free(send_buf);
+	close(fd);
+}
+
+
+/* open or close io_fd after the state or the loop of the handle changed */
+static void bind_io_sync(int slot)
+{
+	const int wanted = g_bind_table[slot].ipc && g_bind_table[slot].sensor_state == SENSOR_STATE_STARTED
+		&& (g_io_thread_on || g_loop_table[g_bind_table[slot].loop_slot].rt);
+
+	if (wanted && g_bind_table[slot].io_fd < 0)
+		bind_io_open(slot);
+	else if (!wanted && g_bind_table[slot].io_fd >= 0)
+		bind_io_close(slot);
+}
+
+
+static gboolean bind_io_reopen_cb(gpointer data)
+{
+	const int slot = handle_to_slot((int)(long)data);
+	int reopen;
+
+	if (slot < 0)
+		return FALSE;
+
+	io_lock();
+	reopen = g_bind_table[slot].io_reopen;
+	g_bind_table[slot].io_reopen = 0;
+	io_unlock();
+
+	if (reopen == 2)
+		bind_io_close(slot);
+	bind_io_sync(slot);
+
+	return FALSE;
+}
+
+
+/*
+ * A thread found io_fd missing, or broken when broken is set : the fetch of the handle
+ * waits for the default context to open it again. Called under g_io_lock.
+ */
+static void bind_io_reopen(int slot, int broken)
+{
+	GSource *source;
+
+	if (g_bind_table[slot].io_reopen) {
+		if (broken)
+			g_bind_table[slot].io_reopen = 2;
+		return;
+	}
+
+	g_bind_table[slot].io_reopen = broken ? 2 : 1;
+
+	source = g_idle_source_new();
+	g_source_set_priority(source, G_PRIORITY_DEFAULT);
+	g_source_set_callback(source, bind_io_reopen_cb, (void *)(long)g_bind_table[slot].my_handle, NULL);
+	g_source_attach(source, NULL);
+	g_source_unref(source);
+}
+
+
+struct sf_connect_req_t {
+	int slot;
+	int handle;
+	const char *channel_name;
+	sensor_connect_cb_t cb;
+	void *user_data;
+	csock *ipc;
+	int ret;								/*what sf_connect() would return on failure, 0 on success*/
+	int err;								/*errno of the failed step*/
+};
+
+
+static gboolean connect_async_complete(gpointer data)
+{
+	sf_connect_req_t *req = (sf_connect_req_t *)data;
+	int slot = req->slot;
+	int handle;
+
+	if (g_bind_table[slot].my_handle != req->handle) {
+		ERR("handle [%d] released while connecting\n", req->handle);
+		delete req->ipc;
+		req->ipc = NULL;
+		req->ret = -2;
+		req->err = ECOMM;
+	}
+
+	if (req->ret < 0) {
+		if (g_bind_table[slot].my_handle == req->handle)
+			release_handle(slot);
+		handle = req->ret;
+		errno = req->err;
+	} else {
+		g_bind_table[slot].ipc = req->ipc;
+		system_off_set();
+		handle = req->handle;
+		INFO("Connected sensor type : %x , handle : %d \n", g_bind_info[slot].sensor_type, handle);
+	}
+
+	if (req->cb)
+		req->cb(handle, req->user_data);
+
+	free(req);
+	return FALSE;
+}
+
+
+static void *connect_async_worker(void *data)
+{
+	sf_connect_req_t *req = (sf_connect_req_t *)data;
+	GSource *source;
+
+	req->ipc = NULL;
+	req->ret = bind_hello(&req->ipc, req->channel_name);
+	req->err = (req->ret < 0) ? errno : 0;
+
+	source = g_idle_source_new();
+	g_source_set_priority(source, G_PRIORITY_DEFAULT);
+	g_source_set_callback(source, connect_async_complete, req, NULL);
+	g_source_attach(source, NULL);
+	g_source_unref(source);
+
+	return NULL;
+}
+
+
+/* connection of a handle in one wheel run, see stream_fetch_flush() */
+enum fetch_conn_state {
+	FETCH_CONN_PENDING = 0,					/*not fetched yet*/
+	FETCH_CONN_SKIPPED,						/*no connection in this run*/
+	FETCH_CONN_BROKEN,						/*failed, the connection is reopened or released*/
+	FETCH_CONN_DONE,						/*fetched through io_uring*/
+};
+
+/* a connection of stream_fetch_uring() */
+struct uring_conn_t {
+	int handle;
+	int fd;
+	int sent;								/*the send of its requests went out, at least in part*/
+	unsigned int send_off;
+	unsigned int send_len;
+	unsigned int recv_off;
+	unsigned int recv_cap;
+	unsigned int recv_len;
+	unsigned int parsed;
+	unsigned int next;						/*fetch entry waiting for the next reply*/
+	int broken;								/*negative errno of the failed operation*/
+};
+
+#define URING_FETCH_ENTRIES				(2 * MAX_BIND_SLOT)
+#define URING_SEND(k)					((unsigned long long)(k) << 1)
+#define URING_RECV(k)					(((unsigned long long)(k) << 1) | 1)
+
+
+/*
+ * Fetch of a wheel run through io_uring : each connection gets one SEND of its requests
+ * linked to one RECV of all its replies, and the whole run takes a single io_uring_enter(),
+ * more only when a reply arrives split. It serves io_fd of the handles, so only loops
+ * of the I/O or the real-time thread use it. Connections it did not fetch are left
+ * FETCH_CONN_PENDING when nothing was sent on them, for the socket fetch of the same run.
+ */
+static void stream_fetch_uring(sf_loop_table_t *loop, int *conn_state)
+{
+	cpacket request(sizeof(cmd_get_data_t)+4);
+	const unsigned int request_size = request.header_size() + sizeof(cmd_get_data_t);
+	const unsigned int reply_max = request.header_size() + sizeof(cmd_get_struct_t) + sizeof(base_data_struct) + 4;
+	uring_conn_t conn[MAX_BIND_SLOT];
+	uring_conn_t *c;
+	sf_fetch_t *fetch;
+	char *send_buf;
+	char *recv_buf;
+	unsigned int conn_num = 0;
+	unsigned int send_size = 0;
+	unsigned int recv_size = 0;
+	unsigned int inflight = 0;
+	unsigned long long user_data;
+	unsigned int i, j, k;
+	int handle;
+	int size;
+	int res;
+
+	if (g_uring_state < 0)
+		return;
+
+	if (!loop->uring.is_ready() && !loop->uring.init(URING_FETCH_ENTRIES)) {
+		INFO("io_uring is not available, samples are fetched with socket calls\n");
+		g_uring_state = -1;
+		return;
+	}
+
+	if (!loop->uring_buf) {
+		loop->uring_buf = (char *)malloc(MAX_STREAM_SLOT * (request_size + reply_max));
+		if (!loop->uring_buf) {
+			ERR("cannot find memory for uring_buf");
+			return;
+		}
+
+		if (loop->rt)
+			rt_mlock(loop->uring_buf, MAX_STREAM_SLOT * (request_size + reply_max));
+	}
+
+	send_buf = loop->uring_buf;
+	recv_buf = loop->uring_buf + MAX_STREAM_SLOT * request_size;
+
+	for (i = 0; i < loop->fetch_num; i++) {
+		handle = loop->fetch[i].handle;
+
+		for (k = 0; k < conn_num && conn[k].handle != handle; k++);
+		if (k < conn_num || conn_state[handle] != FETCH_CONN_PENDING)
+			continue;
+
+		/* opened with the start of the handle, see bind_io_open() */
+		if (g_bind_table[handle].io_fd < 0 || g_bind_table[handle].io_reopen) {
+			bind_io_reopen(handle, 0);
+			conn_state[handle] = FETCH_CONN_SKIPPED;
+			continue;
+		}
+
+		c = &conn[conn_num++];
+		c->handle = handle;
+		c->fd = g_bind_table[handle].io_fd;
+		c->sent = 0;
+		c->send_off = send_size;
+		c->recv_off = recv_size;
+		c->recv_len = 0;
+		c->parsed = 0;
+		c->next = i;
+		c->broken = 0;
+
+		/* state 1 marks a request whose reply is awaited */
+		for (j = i; j < loop->fetch_num; j++) {
+			if (loop->fetch[j].handle != handle || !server_get_struct_request(request, loop->fetch[j].data_id))
+				continue;
+
+			memcpy(send_buf + send_size, request.packet(), request_size);
+			send_size += request_size;
+			recv_size += reply_max;
+			loop->fetch[j].state = 1;
+		}
+
+		c->send_len = send_size - c->send_off;
+		c->recv_cap = recv_size - c->recv_off;
+	}
+
+	g_uring_state = 1;
+
+	for (k = 0; k < conn_num; k++) {
+		c = &conn[k];
+
+		if (!loop->uring.prep_send(c->fd, send_buf + c->send_off, c->send_len, URING_SEND(k), true)) {
+			c->broken = -EBUSY;
+			continue;
+		}
+		inflight++;
+
+		/* a failed send cancels the receive linked to it */
+		if (loop->uring.prep_recv(c->fd, recv_buf + c->recv_off, c->recv_cap, URING_RECV(k)))
+			inflight++;
+	}
+
+	while (inflight) {
+		if (loop->uring.submit_and_wait(inflight) < 0) {
+			/* receives may still be pending on uring_buf, the ring is not used again and the shutdown ends them */
+			ERR("io_uring fetch failed, samples are fetched with socket calls from now on\n");
+			g_uring_state = -1;
+
+			for (k = 0; k < conn_num; k++) {
+				shutdown(conn[k].fd, SHUT_RDWR);
+				conn_state[conn[k].handle] = FETCH_CONN_BROKEN;
+			}
+
+			for (i = 0; i < loop->fetch_num; i++) {
+				if (loop->fetch[i].state > 0)
+					loop->fetch[i].state = -1;
+			}
+
+			return;
+		}
+
+		while (loop->uring.reap(&user_data, &res)) {
+			c = &conn[user_data >> 1];
+			inflight--;
+
+			if (user_data & 1) {
+				if (res > 0)
+					c->recv_len += res;
+				else if (!c->broken)
+					c->broken = res ? res : -ECONNRESET;
+			} else {
+				if (res > 0)
+					c->sent = 1;
+				if (res != (int)c->send_len && !c->broken)
+					c->broken = (res < 0) ? res : -EIO;
+			}
+		}
+
+		/* replies of a connection come back in request order */
+		for (k = 0; k < conn_num; k++) {
+			c = &conn[k];
+
+			while (!c->broken) {
+				while (c->next < loop->fetch_num && (loop->fetch[c->next].handle != c->handle || loop->fetch[c->next].state != 1))
+					c->next++;
+
+				if (c->next == loop->fetch_num)
+					break;
+
+				fetch = &loop->fetch[c->next];
+				size = server_get_struct_parse(recv_buf + c->recv_off + c->parsed, c->recv_len - c->parsed, &fetch->sample, &fetch->state);
+				if (size < 0)
+					c->broken = -EPROTO;
+				else if (!size)
+					break;
+				else
+					c->parsed += size;
+			}
+
+			if (c->broken || c->next == loop->fetch_num)
+				continue;
+
+			if (c->recv_len == c->recv_cap) {
+				c->broken = -EPROTO;
+				continue;
+			}
+
+			if (loop->uring.prep_recv(c->fd, recv_buf + c->recv_off + c->recv_len, c->recv_cap - c->recv_len, URING_RECV(k)))
+				inflight++;
+			else
+				c->broken = -EBUSY;
+		}
+	}
+
+	for (k = 0; k < conn_num; k++) {
+		c = &conn[k];
+		if (!c->broken) {
+			conn_state[c->handle] = FETCH_CONN_DONE;
+			continue;
+		}
+
+		ERR("io_uring fetch of handle [%d] failed , res : %d\n", c->handle, c->broken);
+		if (c->broken == -EINVAL || c->broken == -EOPNOTSUPP)
+			g_uring_state = -1;
+
+		/* nothing went out, the socket fetch takes the connection as it is */
+		if (c->sent)
+			conn_state[c->handle] = FETCH_CONN_BROKEN;
+	}
+
+	for (i = 0; i < loop->fetch_num; i++) {
+		if (loop->fetch[i].state > 0)
+			loop->fetch[i].state = -1;
+	}
+}
+
+
+/* server_get_struct_reply() on io_fd */
+static int server_get_struct_reply_fd(int fd, sensor_data_t *values)
+{
+	cpacket packet(sizeof(cmd_get_struct_t)+sizeof(base_data_struct)+4);
+	const unsigned int reply_max = packet.header_size() + sizeof(cmd_get_struct_t) + sizeof(base_data_struct) + 4;
+
+	if (!fd_recv_all(fd, (char *)packet.packet(), packet.header_size())) {
+		errno = ECOMM;
+		return -2;
+	}
+
+	if ((unsigned int)(packet.header_size() + packet.payload_size()) > reply_max) {
+		errno = EPROTO;
+		return -2;
+	}
+
+	if (packet.payload_size()) {
+		if (!fd_recv_all(fd, (char *)packet.packet() + packet.header_size(), packet.payload_size())) {
+			errno = ECOMM;
+			return -2;
+		}
+	}
+
+	return server_get_struct_values(packet, values);
+}
+
+
+/*
+ * Fetch of a wheel run on the sockets of the handles : the requests of a connection
+ * go out in a single send, and replies are only read once every connection
+ * has been sent to, so the run costs one round trip instead of one per stream.
+ * It takes the connections still FETCH_CONN_PENDING, io_fd with offload and ipc otherwise.
+ */
+static void stream_fetch_sock(sf_loop_table_t *loop, int offload, int *conn_state)
+{
+	cpacket request(sizeof(cmd_get_data_t)+4);
+	sf_fetch_t *fetch;
+	char *send_buf;
+	int send_size;
+	unsigned int i, j;
+	int handle;
+	int state;
+	bool sent;
+
+	send_buf = (char *)malloc(request.size() * loop->fetch_num);
+	if (!send_buf) {
+		ERR("cannot find memory for send_buf");
+		return;
+	}
+
+	/* requests of each connection back to back, in the order of the batch */
+	for (i = 0; i < loop->fetch_num; i++) {
+		handle = loop->fetch[i].handle;
+
+		for (j = 0; j < i && loop->fetch[j].handle != handle; j++);
+		if (j < i || conn_state[handle] != FETCH_CONN_PENDING)
+			continue;
+
+		if (offload) {
+			if (g_bind_table[handle].io_fd < 0 || g_bind_table[handle].io_reopen) {
+				bind_io_reopen(handle, 0);
+				conn_state[handle] = FETCH_CONN_SKIPPED;
+				continue;
+			}
+		} else if (server_drain_replies(handle) < 0) {
+			conn_state[handle] = FETCH_CONN_SKIPPED;
+			continue;
+		}
+
+		send_size = 0;
+		for (j = i; j < loop->fetch_num; j++) {
+			if (loop->fetch[j].handle != handle || !server_get_struct_request(request, loop->fetch[j].data_id))
+				continue;
+
+			memcpy(send_buf + send_size, request.packet(), request.size());
+			send_size += request.size();
+			loop->fetch[j].state = 0;
+		}
+
+		if (offload)
+			sent = fd_send_all(g_bind_table[handle].io_fd, send_buf, send_size);
+		else
+			sent = g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(send_buf, send_size);
+
+		if (!sent) {
+			ERR("Failed to send sample requests of handle [%d]\n", handle);
+			conn_state[handle] = FETCH_CONN_BROKEN;
+		}
+	}
+
+	free(send_buf);
+
+	/* replies of a connection come back in request order */
+	for (i = 0; i < loop->fetch_num; i++) {
+		fetch = &loop->fetch[i];
+		handle = fetch->handle;
+
+		if (conn_state[handle] == FETCH_CONN_DONE)
+			continue;
+
+		if (conn_state[handle] != FETCH_CONN_PENDING || fetch->state < 0) {
+			fetch->state = -1;
+			continue;
+		}
+
+		if (offload)
+			state = server_get_struct_reply_fd(g_bind_table[handle].io_fd, &fetch->sample);
+		else
+			state = server_get_struct_reply(g_bind_table[handle].ipc, &fetch->sample);
+		if (state == -2)
+			conn_state[handle] = FETCH_CONN_BROKEN;
+
+		fetch->state = state;
+	}
+}
+
+
+/*
+ * Samples of the streams due in one wheel run are fetched together,
+ * with io_uring when the kernel offers it and the loop has a thread, see stream_fetch_uring(),
+ * and otherwise pipelined on the sockets, see stream_fetch_sock().
+ * With the I/O or the real-time thread, samples are taken on connections
+ * of their own, so they never interleave with requests of the application on ipc,
+ * and are handed to the loop of their stream through its io_ring.
+ */
+static void stream_fetch_flush(int loop_slot)
+{
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	const int offload = g_io_thread_on || loop->rt;
+	const unsigned long long one = 1;
+	sf_fetch_t *fetch;
+	io_record_t record;
+	int conn_state[MAX_BIND_SLOT];
+	int pushed = 0;
+	unsigned int i;
+
+	if (!loop->fetch_num)
+		return;
+
+	for (i = 0; i < MAX_BIND_SLOT; i++)
+		conn_state[i] = FETCH_CONN_PENDING;
+
+	for (i = 0; i < loop->fetch_num; i++)
+		loop->fetch[i].state = -1;
+
+	/* the default loop shares ipc with the application, which io_uring cannot wait on */
+	if (offload)
+		stream_fetch_uring(loop, conn_state);
+	stream_fetch_sock(loop, offload, conn_state);
+
+	for (i = 0; i < loop->fetch_num; i++) {
+		fetch = &loop->fetch[i];
+		if (fetch->state < 0)
+			continue;
+
+		if (offload) {
+			record.stream_slot = fetch->stream_slot;
+			record.data_id = fetch->data_id;
+			record.tick = fetch->tick;
+			record.batch_cb = -1;
+			record.sample = fetch->sample;
+
+			if (!io_ring_push(&loop->io_ring, &record))
+				loop->io_dropped++;
+			else
+				pushed++;
+			continue;
+		}
+
+		/* callbacks of an earlier sample may have changed the stream */
+		if (g_stream_table[fetch->stream_slot].subscriber_num == 0 || g_stream_table[fetch->stream_slot].data_id != fetch->data_id)
+			continue;
+
+		stream_fanout(&g_stream_table[fetch->stream_slot], &fetch->sample, fetch->tick);
+	}
+
+	loop->fetch_num = 0;
+
+	if (pushed && write(loop->io_notify_fd, &one, sizeof(one)) != sizeof(one))
+		ERR("write io_notify_fd fail , errno : %d\n", errno);
+
+	/* a broken connection of the thread is reopened on the default context, a broken ipc is released */
+	for (i = 0; i < MAX_BIND_SLOT; i++) {
+		if (conn_state[i] != FETCH_CONN_BROKEN)
+			continue;
+
+		if (offload) {
+			bind_io_reopen(i, 1);
+		} else if (g_bind_table[i].ipc) {
+			release_handle(i);
+		}
+	}
+}
+
+
+static void *io_thread_main(void *data)
+{
+	struct epoll_event events[MAX_LOOP_SLOT + 1];
+	unsigned long long count;
+	int event_num;
+	int i;
+
+	while (!g_io_thread_stop) {
+		event_num = epoll_wait(g_io_epfd, events, MAX_LOOP_SLOT + 1, -1);
+		if (event_num < 0) {
+			if (errno == EINTR)
+				continue;
+			ERR("epoll_wait fail , errno : %d\n", errno);
+			break;
+		}
+
+		for (i = 0; i < event_num; i++) {
+			if (events[i].data.u32 >= MAX_LOOP_SLOT) {
+				if (read(g_io_wake_fd, &count, sizeof(count)) < 0)
+					ERR("read g_io_wake_fd fail , errno : %d\n", errno);
+				continue;
+			}
+
+			pthread_mutex_lock(&g_io_lock);
+			g_loop_table[events[i].data.u32].wheel.run(0);
+			stream_fetch_flush(events[i].data.u32);
+			pthread_mutex_unlock(&g_io_lock);
+		}
+	}
+
+	return NULL;
+}
+
+
+static int io_thread_start(void)
+{
+	struct epoll_event ev;
+	int i;
+
+	g_io_epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (g_io_epfd < 0) {
+		ERR("epoll_create1 fail , errno : %d\n", errno);
+		return -2;
+	}
+
+	g_io_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (g_io_wake_fd < 0) {
+		ERR("eventfd fail , errno : %d\n", errno);
+		close(g_io_epfd);
+		g_io_epfd = -1;
+		return -2;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = MAX_LOOP_SLOT;
+	epoll_ctl(g_io_epfd, EPOLL_CTL_ADD, g_io_wake_fd, &ev);
+
+	g_io_thread_stop = 0;
+	g_io_thread_on = 1;
+
+	/* wheels already running move from their loop to the thread */
+	for (i = 0; i < MAX_LOOP_SLOT; i++) {
+		if (!g_loop_table[i].timer_source)
+			continue;
+
+		g_source_remove_poll(g_loop_table[i].timer_source, &g_loop_table[i].timer_pollfd);
+		io_watch_wheel(i);
+		io_source_attach(i);
+	}
+
+	if (pthread_create(&g_io_thread, NULL, io_thread_main, NULL) != 0) {
+		ERR("Failed to create I/O thread\n");
+		io_thread_stop_wait(0);
+		errno = EAGAIN;
+		return -2;
+	}
+
+	return 0;
+}
+
+
+static void io_thread_stop_wait(int joinable)
+{
+	const unsigned long long one = 1;
+	int i;
+
+	if (joinable) {
+		g_io_thread_stop = 1;
+		if (write(g_io_wake_fd, &one, sizeof(one)) != sizeof(one))
+			ERR("write g_io_wake_fd fail , errno : %d\n", errno);
+		pthread_join(g_io_thread, NULL);
+	}
+
+	g_io_thread_on = 0;
+
+	for (i = 0; i < MAX_LOOP_SLOT; i++) {
+		if (g_loop_table[i].timer_source)
+			g_source_add_poll(g_loop_table[i].timer_source, &g_loop_table[i].timer_pollfd);
+	}
+
+	close(g_io_wake_fd);
+	g_io_wake_fd = -1;
+	close(g_io_epfd);
+	g_io_epfd = -1;
+}
+
+
+/*
+ * The real-time thread runs the wheel of its loop like the I/O thread, then drains
+ * the io_ring and calls the callbacks itself, all outside of any glib main loop.
+ * A whole round holds g_io_lock, which the API takes around every change of the tables,
+ * queues and record files the round reads. The lock is recursive, so callbacks may call the API.
+ * What needs another thread is handed off : retunes go to the default context,
+ * see adaptive_update(), and the LCD on release comes back as release_pending.
+ */
+static void *rt_thread_main(void *data)
+{
+	sf_loop_table_t *loop = &g_loop_table[g_rt_slot];
+	struct epoll_event events[2];
+	char prefault[RT_STACK_PREFAULT];
+	int event_num;
+	int i;
+
+	/* touch and lock the stack the callbacks will use, a page fault is a missed deadline */
+	memset(prefault, 0, sizeof(prefault));
+	if (mlock(prefault, sizeof(prefault)) < 0)
+		ERR("mlock of real-time stack fail , errno : %d\n", errno);
+
+	for (;;) {
+		event_num = epoll_wait(g_rt_epfd, events, 2, -1);
+		if (event_num < 0) {
+			if (errno == EINTR)
+				continue;
+			ERR("epoll_wait fail , errno : %d\n", errno);
+			break;
+		}
+
+		pthread_mutex_lock(&g_io_lock);
+
+		for (i = 0; i < event_num; i++) {
+			if (events[i].data.u32 != 0)
+				continue;
+
+			loop->wheel.run(0);
+			stream_fetch_flush(g_rt_slot);
+		}
+
+		io_ring_drain(g_rt_slot);
+
+		for (i = 0; i < MAX_BIND_SLOT; i++) {
+			if (!g_bind_table[i].release_pending)
+				continue;
+
+			g_bind_table[i].release_pending = 0;
+			if (g_bind_table[i].loop_slot == g_rt_slot)
+				delivery_release(i);
+		}
+
+		for (i = 0; i < SENSOR_PRIORITY_NUM; i++)
+			delivery_dispatch(g_rt_slot, g_delivery_order[i], 0);
+
+		pthread_mutex_unlock(&g_io_lock);
+	}
+
+	return NULL;
+}
+
+
+static int rt_wheel_attach(int loop_slot)
+{
+	sf_loop_table_t *loop = &g_loop_table[loop_slot];
+	struct epoll_event ev;
+
+	if (loop->wheel.get_fd() >= 0)
+		return 0;
+
+	if (!loop->wheel.init()) {
+		ERR("cannot create timer wheel");
+		return -1;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = 0;
+	if (epoll_ctl(g_rt_epfd, EPOLL_CTL_ADD, loop->wheel.get_fd(), &ev) < 0) {
+		ERR("epoll_ctl fail , errno : %d\n", errno);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static void rt_thread_apply(int priority, int cpu)
+{
+	struct sched_param param;
+	cpu_set_t cpuset;
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+	if (pthread_setschedparam(g_rt_thread, SCHED_FIFO, &param) != 0)
+		ERR("cannot set SCHED_FIFO priority %d to the real-time thread, it keeps its scheduling\n", priority);
+
+	if (cpu < 0)
+		return;
+
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+	if (pthread_setaffinity_np(g_rt_thread, sizeof(cpuset), &cpuset) != 0)
+		ERR("cannot bind the real-time thread to cpu %d\n", cpu);
+}
+
+
+/* the loop slot of the real-time thread, created with the thread on first use */
+static int rt_loop_acquire(int priority, int cpu)
+{
+	sf_loop_table_t *loop;
+	struct epoll_event ev;
+	int i;
+
+	if (g_rt_thread_on) {
+		rt_thread_apply(priority, cpu);
+		g_loop_table[g_rt_slot].bind_num++;
+		return g_rt_slot;
+	}
+
+	for (i = 1; i < MAX_LOOP_SLOT && g_loop_table[i].in_use; i++);
+	if (i == MAX_LOOP_SLOT) {
+		ERR("MAX_LOOP_SLOT, Too many main context required");
+		errno = ENOMEM;
+		return -1;
+	}
+
+	loop = &g_loop_table[i];
+
+	g_rt_epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (g_rt_epfd < 0) {
+		ERR("epoll_create1 fail , errno : %d\n", errno);
+		return -1;
+	}
+
+	loop->io_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (loop->io_notify_fd < 0) {
+		ERR("eventfd fail , errno : %d\n", errno);
+		close(g_rt_epfd);
+		g_rt_epfd = -1;
+		return -1;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = 1;
+	epoll_ctl(g_rt_epfd, EPOLL_CTL_ADD, loop->io_notify_fd, &ev);
+
+	loop->in_use = 1;
+	loop->rt = 1;
+	loop->context = NULL;
+	loop->bind_num = 1;
+	loop->io_ring.head = 0;
+	loop->io_ring.tail = 0;
+
+	/* everything the thread touches per tick stays resident, queues and record files follow their handle */
+	rt_mlock(loop, sizeof(sf_loop_table_t));
+	rt_mlock(g_stream_table, sizeof(g_stream_table));
+	rt_mlock(g_cb_table, sizeof(g_cb_table));
+	rt_mlock(g_cb_info, sizeof(g_cb_info));
+	rt_mlock(g_bind_table, sizeof(g_bind_table));
+	rt_mlock(g_exec_box, sizeof(g_exec_box));
+	rt_mlock(g_record_table, sizeof(g_record_table));
+
+	g_rt_slot = i;
+	g_rt_thread_on = 1;
+
+	if (pthread_create(&g_rt_thread, NULL, rt_thread_main, NULL) != 0) {
+		ERR("Failed to create real-time thread\n");
+		g_rt_thread_on = 0;
+		g_rt_slot = -1;
+		loop->in_use = 0;
+		loop->rt = 0;
+		loop->bind_num = 0;
+		close(loop->io_notify_fd);
+		loop->io_notify_fd = -1;
+		close(g_rt_epfd);
+		g_rt_epfd = -1;
+		errno = EAGAIN;
+		return -1;
+	}
+
+	pthread_detach(g_rt_thread);
+	rt_thread_apply(priority, cpu);
+
+	return i;
+}
+
+
+/* registered ON_TIME events move to streams of the new loop, with their queued samples */
+static void bind_move_loop(int slot, int loop_slot)
+{
+	const int old_loop_slot = g_bind_table[slot].loop_slot;
+	sensor_data_t *queue;
+	int cb_number;
+	int j;
+
+	/* the thread of either loop sees the handle wholly in one of them */
+	io_lock();
+
+	for (j = 0; j < g_bind_info[slot].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND; j++) {
+		cb_number = g_bind_info[slot].cb_slot_num[j];
+		if (cb_number < 0 || !g_cb_table[cb_number].request_data_id)
+			continue;
+
+		stream_del_subscriber(cb_number);
+		batch_timer_cancel(cb_number);
+		queue_account(cb_number, -(int)g_cb_table[cb_number].collected_num);
+	}
+
+	g_bind_table[slot].loop_slot = loop_slot;
+
+	for (j = 0; j < g_bind_info[slot].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND; j++) {
+		cb_number = g_bind_info[slot].cb_slot_num[j];
+		if (cb_number < 0 || !g_cb_table[cb_number].request_data_id)
+			continue;
+
+		queue = (sensor_data_t *)g_cb_table[cb_number].collected_data;
+		if (g_loop_table[loop_slot].rt && queue)
+			rt_mlock(queue, sizeof(sensor_data_t) * g_cb_table[cb_number].request_count);
+
+		if (g_loop_table[loop_slot].rt && g_cb_table[cb_number].record_slot >= 0)
+			record_lock(g_cb_table[cb_number].record_slot);
+
+		queue_account(cb_number, (int)g_cb_table[cb_number].collected_num);
+		if (stream_add_subscriber(cb_number) < 0)
+			ERR("cannot move cb_handle [%d] to its new loop\n", cb_number);
+
+		/* the wheel of the new loop is set up with its first stream */
+		if (g_cb_table[cb_number].batch_latency && g_cb_table[cb_number].collected_num)
+			batch_timer_arm(cb_number);
+	}
+
+	loop_release(old_loop_slot);
+
+	io_unlock();
+
+	/* a loop of the I/O or the real-time thread needs io_fd, the others do not */
+	bind_io_sync(slot);
+}
+
+
+/* the registered ON_TIME subscriptions of a handle, or the one of event_type */
+static int record_find_cb(int slot, unsigned int event_type, int *cb_list)
+{
+	int cb_slot_idx;
+	int cb_number;
+	int cb_num = 0;
+	int j;
+
+	if (event_type) {
+		cb_slot_idx = event_find_cb_slot(slot, event_type);
+		if (cb_slot_idx < 0)
+			return 0;
+
+		cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+		if (g_cb_table[cb_number].request_data_id)
+			cb_list[cb_num++] = cb_number;
+
+		return cb_num;
+	}
+
+	for (j = 0; j < g_bind_info[slot].cb_event_max_num && j < MAX_CB_SLOT_PER_BIND; j++) {
+		cb_number = g_bind_info[slot].cb_slot_num[j];
+		if (cb_number >= 0 && g_cb_table[cb_number].request_data_id)
+			cb_list[cb_num++] = cb_number;
+	}
+
+	return cb_num;
+}
+
+
+EXTAPI int sf_connect(sensor_type_t sensor_type)
+{
+	int i;
+	int state;
+	int err;
+	csock *ipc = NULL;
+	const char *sf_channel_name = NULL;
+
+	INFO("Sensor_attach_channel from pid : %d , to sensor_type : %x",getpid() ,sensor_type);
+	
+	i = bind_prepare(sensor_type, &sf_channel_name);
+	if (i < 0)
+		return i;
+
+	state = bind_hello(&ipc, sf_channel_name);
+	if (state < 0) {
+		err = errno;
+		release_handle(i);
+		errno = err;
+		return state;
+	}
+
+	g_bind_table[i].ipc = ipc;
+
+	system_off_set();
+
+	INFO("Connected sensor type : %x , handle : %d \n", sensor_type , g_bind_table[i].my_handle);	
+	return g_bind_table[i].my_handle;	
+}
+
+EXTAPI int sf_disconnect(int handle)
+{
+	int slot;
+	cpacket packet(sizeof(cmd_byebye_t)+4);
+	cmd_byebye_t *payload;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_detach_channel fail , invalid handle value : %d",handle);
+
+	INFO("Detach, so remove %d from the table\n", handle);
+
+	payload = (cmd_byebye_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_BYEBYE);
+	packet.set_payload_size(sizeof(cmd_byebye_t));
+
+	if (server_drain_replies(slot) < 0)
+		goto out;
+
+	if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Failed to send, but delete handle\n");
+		errno = ECOMM;
+		goto out;
+	}
+
+	INFO("Recv a reply packet\n");
+	if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->recv(packet.packet(), packet.header_size()) == false) {
+		ERR("Send to reply packet fail\n");
+		errno = ECOMM;
+		goto out;
+	}
+
+	if (packet.payload_size()) {
+		if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
+			ERR("Failed to recv packet\n");
+			errno = ECOMM;
+		}
+	}
+
+out:
+	release_handle(slot);
+	system_off_unset();
+	return 0;
+	
+}
+
+EXTAPI int sf_start(int handle , int option)
+{
+	int slot;
+	int lcd_state = 0;
+	int state;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_start fail , invalid handle value : %d",handle);
+	retvm_if( option < 0 , -1 , "sensor_start fail , invalid option value : %d",option);
+	retvm_if( g_bind_table[slot].sensor_state == SENSOR_STATE_STARTED , 0 , "sensor already started");
+
+	if(option != SENSOR_OPTION_ALWAYS_ON)
+	{
+		if(vconf_get_int(VCONFKEY_PM_STATE, &lcd_state) == 0)
+		{
+			if(lcd_state == VCONFKEY_PM_STATE_LCDOFF && option != SENSOR_OPTION_BUFFER_LCD_OFF)
+			{
+				io_lock();
+				g_bind_table[slot].sensor_state = SENSOR_STATE_PAUSED;
+				io_unlock();
+				DBG("SENSOR_STATE_PAUSED(LCD OFF)");
+				return 0;
+			}
+		}
+		else
+		{
+			DBG("vconf_get_int Error lcd_state = [%d]",lcd_state);
+		}
+	}
+	else
+	{
+		DBG("sensor start (SENSOR_OPTION_ALWAYS_ON)");
+	}
+
+	INFO("Sensor S/F Started\n");
+
+	/* the server keeps a buffering sensor powered exactly like an always on one */
+	state = server_send_start(slot, (option == SENSOR_OPTION_BUFFER_LCD_OFF) ? SENSOR_OPTION_ALWAYS_ON : option);
+	if (state < 0)
+		return state;
+
+	state = server_recv_start(slot);
+	if (state < 0)
+		return state;
+
+	io_lock();
+	g_bind_table[slot].sensor_state = SENSOR_STATE_STARTED;
+	g_bind_info[slot].sensor_option = option;
+
+	if(option == SENSOR_OPTION_BUFFER_LCD_OFF && lcd_state == VCONFKEY_PM_STATE_LCDOFF)
+		delivery_hold(slot);
+	io_unlock();
+
+	bind_io_sync(slot);
+
+	return 0;
+
+}
+
+EXTAPI int sf_stop(int handle)
+{
+	int slot;
+	cpacket packet(sizeof(cmd_stop_t)+4);
+	cmd_stop_t *payload;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_stop fail , invalid handle value : %d",handle);
+	retvm_if( (g_bind_table[slot].sensor_state == SENSOR_STATE_STOPPED) || (g_bind_table[slot].sensor_state == SENSOR_STATE_PAUSED) , 0 , "sensor already stopped");
+
+	INFO("Sensor S/F Stopped\n");
+
+	payload = (cmd_stop_t*)packet.data();
+	if (!payload) {
+		ERR("cannot find memory for send packet.data");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	packet.set_version(PROTOCOL_VERSION);
+	packet.set_cmd(CMD_STOP);
+	packet.set_payload_size(sizeof(cmd_stop_t));
+
+	if (server_drain_replies(slot) < 0)
+		return -2;
+
+	if (g_bind_table[slot].ipc && g_bind_table[slot].ipc->send(packet.packet(), packet.size()) == false) {
+		ERR("Failed to send a packet\n");
+		release_handle(slot);
+		errno = ECOMM;
+		return -2;
+	}
+
+	io_lock();
+	g_bind_table[slot].sensor_state = SENSOR_STATE_STOPPED;
+	io_unlock();
+
+	bind_io_sync(slot);
+
+	return 0;
+
+}
+
+EXTAPI int sf_create_group(void)
+{
+	int i;
+
+	_lock.lock();
+	for (i = 0; i < MAX_GROUP_SLOT; i++) {
+		if (!g_group_table[i].in_use) {
+			g_group_table[i].in_use = 1;
+			g_group_table[i].handle_num = 0;
+			break;
+		}
+	}
+	_lock.unlock();
+
+	if (i == MAX_GROUP_SLOT) {
+		ERR("MAX_GROUP_SLOT, Too many group required");
+		errno = ENOMEM;
+		return -2;
+	}
+
+	INFO("Created sensor group : %d\n", i);
+	return i;
+}
+
+EXTAPI int sf_destroy_group(int group)
+{
+	retvm_if( (group < 0) || (group >= MAX_GROUP_SLOT) || !g_group_table[group].in_use , -1 , "Invalid group : %d", group);
+
+	_lock.lock();
+	g_group_table[group].in_use = 0;
+	g_group_table[group].handle_num = 0;
+	_lock.unlock();
+
+	return 0;
+}
+
+EXTAPI int sf_group_add(int group, int handle)
+{
+	int slot;
+	unsigned int i;
+
+	retvm_if( (group < 0) || (group >= MAX_GROUP_SLOT) || !g_group_table[group].in_use , -1 , "Invalid group : %d", group);
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_group_add fail , invalid handle value : %d",handle);
+
+	for (i = 0; i < g_group_table[group].handle_num; i++) {
+		if (g_group_table[group].handle_list[i] == slot)
+			return 0;
+	}
+
+	g_group_table[group].handle_list[g_group_table[group].handle_num++] = slot;
+
+	return 0;
+}
+
+EXTAPI int sf_group_remove(int group, int handle)
+{
+	int slot;
+	unsigned int i, j;
+
+	retvm_if( (group < 0) || (group >= MAX_GROUP_SLOT) || !g_group_table[group].in_use , -1 , "Invalid group : %d", group);
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_group_remove fail , invalid handle value : %d",handle);
+
+	for (i = 0; i < g_group_table[group].handle_num; i++) {
+		if (g_group_table[group].handle_list[i] == slot) {
+			for (j = i; j < g_group_table[group].handle_num - 1; j++)
+				g_group_table[group].handle_list[j] = g_group_table[group].handle_list[j+1];
+			g_group_table[group].handle_num--;
+			return 0;
+		}
+	}
+
+	ERR("handle %d is not a member of group %d", handle, group);
+	errno = EINVAL;
+	return -1;
+}
+
+EXTAPI int sf_group_start(int group, int option)
+{
+	int handle_list[MAX_BIND_SLOT];
+	int sent[MAX_BIND_SLOT];
+	unsigned int handle_num;
+	unsigned int k;
+	int lcd_state = 0;
+	int fail_num = 0;
+
+	retvm_if( (group < 0) || (group >= MAX_GROUP_SLOT) || !g_group_table[group].in_use , -1 , "Invalid group : %d", group);
+	retvm_if( option < 0 , -1 , "sf_group_start fail , invalid option value : %d",option);
+
+	/* members may be released on a socket error, so work on a copy */
+	handle_num = g_group_table[group].handle_num;
+	memcpy(handle_list, g_group_table[group].handle_list, sizeof(int) * handle_num);
+
+	if (option != SENSOR_OPTION_ALWAYS_ON) {
+		if (vconf_get_int(VCONFKEY_PM_STATE, &lcd_state) == 0) {
+			if (lcd_state == VCONFKEY_PM_STATE_LCDOFF && option != SENSOR_OPTION_BUFFER_LCD_OFF) {
+				for (k = 0; k < handle_num; k++) {
+					if (g_bind_table[handle_list[k]].sensor_state != SENSOR_STATE_STARTED) {
+						g_bind_table[handle_list[k]].sensor_state = SENSOR_STATE_PAUSED;
+						g_bind_info[handle_list[k]].sensor_option = option;
+					}
+				}
+				DBG("group %d SENSOR_STATE_PAUSED(LCD OFF)", group);
+				return 0;
+			}
+		} else {
+			DBG("vconf_get_int Error lcd_state = [%d]",lcd_state);
+		}
+	}
+
+	INFO("Sensor S/F group %d Started with %u handle(s)\n", group, handle_num);
+
+	/* Send every CMD_START before waiting for any reply */
+	for (k = 0; k < handle_num; k++) {
+		sent[k] = 0;
+		if (g_bind_table[handle_list[k]].sensor_state == SENSOR_STATE_STARTED)
+			continue;
+
+		if (server_send_start(handle_list[k], (option == SENSOR_OPTION_BUFFER_LCD_OFF) ? SENSOR_OPTION_ALWAYS_ON : option) < 0) {
+			fail_num++;
+			continue;
+		}
+		sent[k] = 1;
+	}
+
+	for (k = 0; k < handle_num; k++) {
+		if (!sent[k])
+			continue;
+
+		if (server_recv_start(handle_list[k]) < 0) {
+			sent[k] = 0;
+			fail_num++;
+			continue;
+		}
+
+		io_lock();
+		g_bind_table[handle_list[k]].sensor_state = SENSOR_STATE_STARTED;
+		g_bind_info[handle_list[k]].sensor_option = option;
+
+		if (option == SENSOR_OPTION_BUFFER_LCD_OFF && lcd_state == VCONFKEY_PM_STATE_LCDOFF)
+			delivery_hold(handle_list[k]);
+		io_unlock();
+
+		bind_io_sync(handle_list[k]);
+	}
+
+	if (fail_num) {
+		ERR("%d handle(s) of group %d failed to start, stopping the rest\n", fail_num, group);
+		for (k = 0; k < handle_num; k++) {
+			if (sent[k])
+				sf_stop(g_bind_table[handle_list[k]].my_handle);
+		}
+		errno = ECOMM;
+		return -2;
+	}
+
+	stream_refresh_all();
+	stream_align(handle_list, handle_num);
+
+	return 0;
+}
+
+EXTAPI int sf_group_stop(int group)
+{
+	int handle_list[MAX_BIND_SLOT];
+	unsigned int handle_num;
+	unsigned int k;
+	int state = 0;
+
+	retvm_if( (group < 0) || (group >= MAX_GROUP_SLOT) || !g_group_table[group].in_use , -1 , "Invalid group : %d", group);
+
+	handle_num = g_group_table[group].handle_num;
+	memcpy(handle_list, g_group_table[group].handle_list, sizeof(int) * handle_num);
+
+	for (k = 0; k < handle_num; k++) {
+		if (g_bind_table[handle_list[k]].sensor_state == SENSOR_STATE_PAUSED) {
+			g_bind_table[handle_list[k]].sensor_state = SENSOR_STATE_STOPPED;
+			continue;
+		}
+
+		if (sf_stop(g_bind_table[handle_list[k]].my_handle) < 0) {
+			ERR("Cannot stop handle [%d] of group %d", handle_list[k], group);
+			state = -2;
+		}
+	}
+
+	stream_refresh_all();
+
+	return state;
+}
+
+EXTAPI int sf_register_event(int handle , unsigned int event_type ,  event_condition_t *event_condition , sensor_callback_func_t cb , void *cb_data )
+{
+	int slot;
+	int cb_number;
+	int cb_slot_idx = -1;
+	unsigned int interval = BASE_GATHERING_INTERVAL;
+	int result = 0;
+	int state;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_register_cb fail , invalid handle value : %d",handle);
+
+	cb_number = event_reg_prepare(slot, event_type, event_condition, cb, cb_data, &cb_slot_idx, &interval);
+	if (cb_number < 0)
+		return cb_number;
+
+	INFO("Sensor S/F register cb\n");
+
+	state = server_reg_events(slot, REG_ADD, &event_type, &interval, 1, &result);
+	if (state < 0) {
+		cb_release_handle(cb_number);
+		return -2;
+	}
+
+	return event_reg_commit(slot, cb_number, cb_slot_idx);
+}
+
+
+EXTAPI int sf_register_events(int handle , unsigned int event_mask , event_condition_t *event_conditions[] , sensor_callback_func_t cb , void *cb_data )
+{
+	int slot;
+	unsigned int event_types[MAX_CB_SLOT_PER_BIND];
+	unsigned int intervals[MAX_CB_SLOT_PER_BIND];
+	int cb_numbers[MAX_CB_SLOT_PER_BIND];
+	int cb_slot_idx[MAX_CB_SLOT_PER_BIND];
+	int results[MAX_CB_SLOT_PER_BIND];
+	unsigned int dangling_types[MAX_CB_SLOT_PER_BIND];
+	int dangling_num = 0;
+	event_condition_t *event_condition;
+	int event_num = 0;
+	int cond_idx = 0;
+	int fail_num = 0;
+	int state;
+	int i, k;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_register_cb fail , invalid handle value : %d",handle);
+	retvm_if( (event_mask >> 16) != (unsigned int)g_bind_info[slot].sensor_type , -1 , "event_mask %x does not belong to handle %d", event_mask, handle);
+	retvm_if( !(event_mask & 0xFFFF) , -1 , "Empty event_mask");
+
+	for (i = 0; i < MAX_CB_SLOT_PER_BIND; i++) {
+		if (!(event_mask & (0x0001 << i)))
+			continue;
+
+		event_condition = event_conditions ? event_conditions[cond_idx] : NULL;
+		cond_idx++;
+
+		event_types[event_num] = (event_mask & (0xFFFF<<16)) | (0x0001 << i);
+		cb_numbers[event_num] = event_reg_prepare(slot, event_types[event_num], event_condition, cb, cb_data, &cb_slot_idx[event_num], &intervals[event_num]);
+		if (cb_numbers[event_num] < 0) {
+			state = cb_numbers[event_num];
+			for (k = 0; k < event_num; k++)
+				cb_release_handle(cb_numbers[k]);
+			return state;
+		}
+		event_num++;
+	}
+
+	INFO("Sensor S/F register %d cb(s) for event_mask : %x\n", event_num, event_mask);
+
+	state = server_reg_events(slot, REG_ADD, event_types, intervals, event_num, results);
+	if (state < -1) {
+		for (k = 0; k < event_num; k++)
+			cb_release_handle(cb_numbers[k]);
+		return state;
+	}
+
+	for (k = 0; k < event_num; k++) {
+		if (results[k] < 0) {
+			cb_release_handle(cb_numbers[k]);
+			fail_num++;
+		} else if (event_reg_commit(slot, cb_numbers[k], cb_slot_idx[k]) < 0) {
+			dangling_types[dangling_num++] = event_types[k];
+			fail_num++;
+		}
+	}
+
+	if (fail_num) {
+		ERR("%d of %d event(s) in event_mask : %x failed, rolling back\n", fail_num, event_num, event_mask);
+		if (dangling_num)
+			server_reg_events(slot, REG_DEL, dangling_types, NULL, dangling_num, results);
+		if (fail_num < event_num)
+			sf_unregister_events(handle, event_mask);
+		errno = ECOMM;
+		return -2;
+	}
+
+	return 0;
+}
+
+
+EXTAPI int sf_unregister_event(int handle, unsigned int event_type)
+{
+	int slot;
+	int cb_slot_idx;
+	int result = 0;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_unregister_cb fail , invalid handle value : %d",handle);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("Err , Cannot find cb_slot_num!! for event : %x\n", event_type );
+		errno = EINVAL;
+		return -1;
 	}
-	
-	if (avail_cb_slot_idx < 0 ) {
-		ERR("Find cb_slot fail, There is  already callback function!!\n");
-		errno = ENOMEM;
+
+	INFO("Sensor S/F unregister cb\n");
+
+	if (server_reg_events(slot, REG_DEL, &event_type, NULL, 1, &result) < -1)
 		return -2;
+
+	return event_unreg_release(slot, cb_slot_idx);
+}
+
+
+EXTAPI int sf_unregister_events(int handle, unsigned int event_mask)
+{
+	int slot;
+	unsigned int event_types[MAX_CB_SLOT_PER_BIND];
+	int cb_slot_idx[MAX_CB_SLOT_PER_BIND];
+	int results[MAX_CB_SLOT_PER_BIND];
+	int event_num = 0;
+	int state = 0;
+	int i, k;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sensor_unregister_cb fail , invalid handle value : %d",handle);
+	retvm_if( (event_mask >> 16) != (unsigned int)g_bind_info[slot].sensor_type , -1 , "event_mask %x does not belong to handle %d", event_mask, handle);
+
+	for (i = 0; i < MAX_CB_SLOT_PER_BIND; i++) {
+		if (!(event_mask & (0x0001 << i)))
+			continue;
+
+		event_types[event_num] = (event_mask & (0xFFFF<<16)) | (0x0001 << i);
+		cb_slot_idx[event_num] = event_find_cb_slot(slot, event_types[event_num]);
+		if (cb_slot_idx[event_num] >= 0)
+			event_num++;
 	}
 
-	i = cb_acquire_handle();
-	if (i == MAX_CB_BIND_SLOT) {
-		ERR("MAX_BIND_SLOT, Too many slot required");
-		errno = ENOMEM;
+	if (!event_num) {
+		ERR("Err , Cannot find any cb_slot_num!! for event_mask : %x\n", event_mask );
+		errno = EINVAL;
+		return -1;
+	}
+
+	INFO("Sensor S/F unregister %d cb(s) for event_mask : %x\n", event_num, event_mask);
+
+	if (server_reg_events(slot, REG_DEL, event_types, NULL, event_num, results) < -1)
 		return -2;
+
+	for (k = 0; k < event_num; k++) {
+		if (event_unreg_release(slot, cb_slot_idx[k]) < 0)
+			state = -2;
 	}
-	INFO("Empty cb_slot : %d\n", i);
 
-	g_cb_table[i].my_cb_handle = i;
-	g_cb_table[i].my_sf_handle = handle;
-		
-	INFO("Sensor S/F register cb\n");	
+	return state;
+}
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_REG);
-	packet.set_payload_size(sizeof(cmd_reg_t));
-	payload->type = REG_ADD;
-	payload->event_type = event_type;
 
-	 if(!event_condition)
-		 payload->interval = BASE_GATHERING_INTERVAL;
-	 else if((event_condition->cond_op == CONDITION_EQUAL) && (event_condition->cond_value1 > 0 ))
-		 payload->interval = event_condition->cond_value1;
-	 else
-		 payload->interval = BASE_GATHERING_INTERVAL;
-	
+EXTAPI int sf_get_data(int handle , unsigned int data_id ,  sensor_data_t* values)
+{
+	int slot;
+	int state;
+	int err;
 
-	INFO("Send CMD_REG command with reg_type : %x , event_typ : %x\n",payload->type , payload->event_type );
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Faield to send a packet\n");
-		cb_release_handle(i);
-		release_handle(handle);
+	
+	retvm_if( (!values) , -1 , "sf_get_data fail , invalid get_values pointer %p", values);
+	retvm_if( ( (data_id & 0xFFFF) < 1) || ( (data_id & 0xFFFF) > 0xFFF), -1 , "sf_get_data fail , invalid data_id %d", data_id);
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_get_data fail , invalid handle value : %d",handle);
+ 
+	if(g_bind_table[slot].sensor_state != SENSOR_STATE_STARTED)
+	{
+		ERR("sensor framewoker doesn't started");
+		values->data_accuracy = SENSOR_ACCURACY_UNDEFINED;
+		values->data_unit_idx = SENSOR_UNDEFINED_UNIT;
+		values->time_stamp = 0;
+		values->values_num = 0;
 		errno = ECOMM;
 		return -2;
 	}
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Faield to receive a packet\n");
-		cb_release_handle(i);
-		release_handle(handle);
-		errno = ECOMM;
+	if (server_drain_replies(slot) < 0)
 		return -2;
+
+	state = server_get_struct(g_bind_table[slot].ipc, data_id, values);
+	if (state == -2) {
+		err = errno;
+		release_handle(slot);
+		errno = err;
 	}
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			ERR("Faield to receive a packet\n");
-			cb_release_handle(i);
-			release_handle(handle);
-			errno = ECOMM;
-			return -2;
+	return (state < 0) ? -2 : 0;
+}
+
+EXTAPI int sf_check_rotation( unsigned long *curr_state)
+{
+	int state = -1;
+
+	double raw_z;
+	double atan_value = 0, norm_z = 0;
+	int acc_theta = 0 , acc_pitch = 0;
+	int handle = 0;
+	int lcd_type = 0;
+
+	sensor_data_t *base_data_values = (sensor_data_t*)malloc(sizeof(sensor_data_t));
+
+	retvm_if( curr_state==NULL , -1 , "sf_check_rotation fail , invalid curr_state");
+
+	*curr_state = ROTATION_UNKNOWN;
+	
+	INFO("Sensor_attach_channel from pid : %d",getpid());
+	
+	handle = sf_connect( ACCELEROMETER_SENSOR);
+	if (handle<0)
+	{
+		ERR("sensor attach fail\n");
+		return 0;
+	}
+
+	state = sf_start(handle, 0);
+	if(state < 0)
+	{
+		ERR("sf_start fail\n");
+		return 0;
+	}
+
+	state = sf_get_data(handle, ACCELEROMETER_BASE_DATA_SET, base_data_values);
+	if(state < 0)
+	{
+		ERR("sf_get_data fail\n");
+		return 0;
+	}
+
+	state = sf_stop(handle);
+	if(state < 0)
+	{
+		ERR("sf_stop fail\n");
+		return 0;
+	}
+
+	state = sf_disconnect(handle);
+	if(state < 0)
+	{
+		ERR("sf_disconnect fail\n");
+		return 0;
+	}
+
+	if((base_data_values->values[0] > XY_POSITIVE_THD || base_data_values->values[0] < XY_NEGATIVE_THD) || (base_data_values->values[1] > XY_POSITIVE_THD || base_data_values->values[1] < XY_NEGATIVE_THD))
+	{
+		atan_value = atan2(-(base_data_values->values[1]),(base_data_values->values[0]));
+		acc_theta = ((int)(atan_value * (RADIAN_VALUE) + 270.0))%360;
+
+		raw_z = (double)(base_data_values->values[2]) / 9.8;
+
+		if ( raw_z > 1.0 ) {
+			norm_z = 1.0;
+		}
+		else if ( raw_z < -1.0 ) {
+			norm_z = -1.0;
+		}
+		else {
+			norm_z = raw_z;
 		}
+		acc_pitch = (int)( acos(norm_z) *(RADIAN_VALUE));
+	}
 
-		if (packet.cmd() == CMD_DONE) {
-			cmd_done_t *payload;
-			payload = (cmd_done_t*)packet.data();
-			if (payload->value == -1) {
-				ERR("server register fail\n");
-				cb_release_handle(i);
-				errno = ECOMM;
-				return -2;
-			} 
-		} else {
-			ERR("unexpected server cmd\n");
-			cb_release_handle(i);
-			errno = ECOMM;
-			return -2;
+	INFO( "cal value [acc_theta] : %d , [acc_pitch] : %d\n",acc_theta ,acc_pitch);
+
+	if( (acc_pitch>PITCH_MIN) && (acc_pitch<PITCH_MAX) ) {
+		if ((acc_theta >= ROTATION_360 - ROTATION_THD && acc_theta <= ROTATION_360 ) ||	(acc_theta >= ROTATION_0 && acc_theta < ROTATION_0 + ROTATION_THD))
+		{
+			*curr_state = rotation_mode[ROTATION_EVENT_0].rm[lcd_type];	
+		}
+		else if(acc_theta >= ROTATION_90 - ROTATION_THD && acc_theta < ROTATION_90 + ROTATION_THD)
+		{
+			*curr_state = rotation_mode[ROTATION_EVENT_90].rm[lcd_type];
+		}
+		else if(acc_theta >= ROTATION_180 - ROTATION_THD && acc_theta < ROTATION_180 + ROTATION_THD)
+		{
+			*curr_state = rotation_mode[ROTATION_EVENT_180].rm[lcd_type];
+		}
+		else if(acc_theta >= ROTATION_270 - ROTATION_THD && acc_theta < ROTATION_270 + ROTATION_THD)
+		{
+			*curr_state = rotation_mode[ROTATION_EVENT_270].rm[lcd_type];	
+		} 
+		else {
+			ERR("Wrong acc_theta : %d , cannot detect current state of ACCEL_SENSOR",acc_theta);
+			*curr_state = rotation_mode[ROTATION_UNKNOWN].rm[lcd_type];
+		}		
+	}else {
+		INFO("Cannot detect current state of ACCEL_SENSOR");
+		*curr_state = rotation_mode[ROTATION_UNKNOWN].rm[lcd_type];
+	}			
+	
+	state = 0;	
+	if(base_data_values)
+	{
+		free(base_data_values);
+		base_data_values = NULL;
+	}
+
+	return state;
+
+}
+
+
+EXTAPI int sf_set_wakeup(sensor_type_t sensor_type)
+{
+	int i = 0;
+
+	if(sf_is_wakeup_supported(sensor_type) < 0)
+	{
+		ERR("Cannot support wake up");
+		return -1;
+	}
+
+	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
+	{
+		if(g_bind_info[i].sensor_type == sensor_type)
+		{
+			g_bind_info[i].wakeup_state = SENSOR_WAKEUP_SETTED;
+		}
+	}
+
+	vconf_notify_key_changed(VCONFKEY_PM_STATE, lcd_off_set_wake_up, NULL);
+
+	return 0;
+}
+
+EXTAPI int sf_unset_wakeup(sensor_type_t sensor_type)
+{
+	int i = 0;
+
+	if(sf_is_wakeup_supported(sensor_type) < 0)
+	{
+		ERR("Cannot support wake up");
+		return -1;
+	}
+	
+	if(sensor_type == ACCELEROMETER_SENSOR)
+		return sf_set_property(sensor_type, ACCELEROMETER_PROPERTY_SET_WAKEUP, WAKEUP_UNSET);
+	else
+	{
+		ERR("Cannot support wakeup");
+		return -1;
+	}
+	
+	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
+	{
+		if(g_bind_info[i].sensor_type == sensor_type)
+		{
+			g_bind_info[i].wakeup_state = SENSOR_WAKEUP_UNSETTED;
 		}
 	}
 
-	memset(g_cb_table[i].call_back_key,'\0',MAX_KEY_LEN);
-	snprintf(g_cb_table[i].call_back_key,(MAX_KEY_LEN-1),"%s%x",DEFAULT_SENSOR_KEY_PREFIX, event_type);
+	vconf_ignore_key_changed(VCONFKEY_PM_STATE, lcd_off_set_wake_up);
+
+	return 0;
+}
+
+EXTAPI int sf_is_wakeup_supported(sensor_type_t sensor_type)
+{
+	if(sensor_type == ACCELEROMETER_SENSOR)
+		return sf_set_property(sensor_type, ACCELEROMETER_PROPERTY_CHECK_WAKEUP_SUPPORTED,	WAKEUP_SET);
+	else
+	{
+		ERR("Cannot support wakeup");
+		return -1;
+	}
+}
+
+EXTAPI int sf_is_wakeup_enabled(sensor_type_t sensor_type)
+{
+	if(sensor_type == ACCELEROMETER_SENSOR)
+		return sf_set_property(sensor_type,ACCELEROMETER_PROPERTY_CHECK_WAKEUP_STATUS,0);
+	else
+	{
+		 ERR("Cannot support wakeup");
+		 return -1;
+	}
+}
+
+EXTAPI int sf_change_event_condition(int handle, unsigned int event_type, event_condition_t *event_condition)
+{
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+	unsigned int interval;
 
-	g_cb_table[i].cb_event_type = event_type;
-	g_cb_table[i].client_data = cb_data;
-	g_cb_table[i].sensor_callback_func_t = cb;
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_change_event_condition fail , invalid handle value : %d",handle);
 
-	switch (event_type ) {
-			case ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case PROXIMITY_EVENT_STATE_REPORT_ON_TIME:
-				/* fall through */
-			case GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case BAROMETER_EVENT_RAW_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case LIGHT_EVENT_LEVEL_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case FUSION_SENSOR_EVENT_RAW_DATA_REPORT_ON_TIME:
-				collect_data_flag = 1;
-				g_cb_table[i].request_data_id = (event_type & (0xFFFF<<16)) |0x0001;
-				break;
-			case LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case BAROMETER_EVENT_TEMPERATURE_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case FUSION_ROTATION_VECTOR_EVENT_DATA_REPORT_ON_TIME:
-				collect_data_flag = 1;
-				g_cb_table[i].request_data_id = (event_type & (0xFFFF<<16)) |0x0002;
-				break;
-			case ACCELEROMETER_EVENT_LINEAR_ACCELERATION_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case FUSION_ROTATION_MATRIX_EVENT_DATA_REPORT_ON_TIME:
-				/* fall through */
-			case BAROMETER_EVENT_ALTITUDE_DATA_REPORT_ON_TIME:
-				collect_data_flag = 1;
-				g_cb_table[i].request_data_id = (event_type & (0xFFFF<<16)) |0x0004;
-				break;
-			default :
-				collect_data_flag = 0;
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
 	}
 
-	INFO("key : %s(p:%p), cb_handle value : %d\n", g_cb_table[i].call_back_key ,g_cb_table[i].call_back_key, i );
-
-	if ( collect_data_flag ) {			
-		sensor_data_t *collected_data_set;		
-		
-		collected_data_set = new sensor_data_t [ON_TIME_REQUEST_COUNTER];
-		if ( !collected_data_set ) {
-			ERR("memory allocation fail for gathering datas\n");
-			cb_release_handle(i);
-			errno = ECOMM;
-			return -2;
-		}
-		g_cb_table[i].collected_data = (void *)collected_data_set;
-		g_cb_table[i].current_collected_idx = 0;
-		
-		if (!event_condition) {
-			g_cb_table[i].gsource_interval = BASE_GATHERING_INTERVAL;
-		} else {
-			if ( (event_condition->cond_op == CONDITION_EQUAL) && (event_condition->cond_value1 > 0 ) ) {
-				g_cb_table[i].gsource_interval = (guint)event_condition->cond_value1;
-			} else {
-				ERR("Invaild input_condition interval , input_interval : %f\n", event_condition->cond_value1);
-				cb_release_handle(i);						
-				errno = EINVAL;
-				return -1;
-			}
-		}
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("Cannot support this API");
+		errno = EINVAL;
+		return -1;
+	}
 
+	if(!event_condition)
+		interval = BASE_GATHERING_INTERVAL;
+	else if((event_condition->cond_op == CONDITION_EQUAL) && (event_condition->cond_value1 > 0 ))
+		interval = (unsigned int)event_condition->cond_value1;
+	else
+		interval = BASE_GATHERING_INTERVAL;
 
-		if ( g_cb_table[i].gsource_interval != 0 ) {
-			g_cb_table[i].source = g_timeout_source_new(g_cb_table[i].gsource_interval);
-		} else {
-			ERR("Error , gsource_interval value : %u",g_cb_table[i].gsource_interval);
-			cb_release_handle(i);
-			errno = EINVAL;
-			return -1;
-		}
-		g_source_set_callback (g_cb_table[i].source, sensor_timeout_handler, (gpointer)&g_cb_table[i].my_cb_handle,NULL);			
-		g_cb_table[i].gID = g_source_attach (g_cb_table[i].source, NULL);		
-		
-	}else {		
-		g_cb_table[i].request_count = 0;
-		g_cb_table[i].request_data_id = 0;
-		g_cb_table[i].collected_data = NULL;
+	if(g_cb_table[cb_number].adaptive_interval)
+		g_cb_info[cb_number].adaptive_base = (guint)interval;
 
-		for(j = 0 ; j < MAX_EVENT_LIST ; j++){
-			if(g_event_list[j].event_type == event_type) {
-				if(g_event_list[j].event_counter < 1){
-					if(vconf_notify_key_changed(g_cb_table[i].call_back_key,sensor_changed_cb,(void*)(j)) == 0 ) {
-						DBG("vconf_add_chaged_cb success for key : %s  , my_cb_handle value : %d\n", g_cb_table[i].call_back_key, g_cb_table[i].my_cb_handle);
-					} else {
-						DBG("vconf_add_chaged_cb fail for key : %s  , my_cb_handle value : %d\n", g_cb_table[i].call_back_key, g_cb_table[i].my_cb_handle);
-						cb_release_handle(i);
-						errno = ENODEV;
-						return -2;
-					}
-				}else {
-					DBG("vconf_add_changed_cb is already registered for key : %s, my_cb_handle	value : %d\n", g_cb_table[i].call_back_key,	g_cb_table[i].my_cb_handle);
-				}
-				add_cb_number(j, i);
-			}
-		}
+	if(g_cb_table[cb_number].gsource_interval == (guint)interval)
+	{
+		ERR("same interval");
+		return -1;
 	}
 
+	/* the stream keeps ticking, the server learns the new rate without a round trip */
+	if (server_post_reg(slot, event_type, interval) < 0)
+		return -2;
 
-	g_bind_table[handle].cb_slot_num[avail_cb_slot_idx] = i;
+	io_lock();
+	g_cb_table[cb_number].gsource_interval = (guint)interval;
+	stream_refresh(g_cb_table[cb_number].stream_slot);
+	io_unlock();
 
 	return 0;
 }
 
-
-EXTAPI int sf_unregister_event(int handle, unsigned int event_type)
+EXTAPI int sf_set_event_queue(int handle, unsigned int event_type, unsigned int depth, int policy)
 {
-	int state = 0;
-	cpacket packet(sizeof(cmd_reg_t)+4);
-	cmd_reg_t *payload;
-	int find_cb_handle =-1;
-	int i = 0, j = 0;
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
 
-	int collect_data_flag = 0;
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_event_queue fail , invalid handle value : %d",handle);
+	retvm_if( (depth < 1) || (depth > MAX_ON_TIME_REQUEST_COUNTER) , -1 , "sf_set_event_queue fail , invalid depth : %u", depth);
+	retvm_if( (policy < SENSOR_QUEUE_DROP_OLDEST) || (policy > SENSOR_QUEUE_BLOCK) , -1 , "sf_set_event_queue fail , invalid policy : %d", policy);
 
-	retvm_if( handle > MAX_BIND_SLOT , -1 , "Incorrect handle");
-	retvm_if( (g_bind_table[handle].ipc == NULL) ||(handle < 0) , -1 , "sensor_unregister_cb fail , invalid handle value : %d",handle);
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
+	}
 
-	payload = (cmd_reg_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("event_type [%x] is not a report on time event", event_type);
+		errno = EINVAL;
+		return -1;
+	}
+
+	io_lock();
+	if (queue_alloc(cb_number, depth, policy) < 0) {
+		io_unlock();
 		errno = ENOMEM;
 		return -2;
 	}
+	io_unlock();
 
-	for ( i=0 ; i<g_bind_table[handle].cb_event_max_num ; i++ ) {
-		if (  g_bind_table[handle].cb_slot_num[i] != -1 ) {	
-			
-			if ( event_type == g_cb_table[ g_bind_table[handle].cb_slot_num[i] ].cb_event_type) {
-				find_cb_handle = g_bind_table[handle].cb_slot_num[i];
-				break;
-			}			
-		}		
-	}
+	return 0;
+}
 
-	if (find_cb_handle < 0) {
-		ERR("Err , Cannot find cb_slot_num!! for event : %x\n", event_type );
+EXTAPI int sf_get_event_stats(int handle, unsigned int event_type, sensor_event_stats_t *stats)
+{
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+
+	retvm_if( !stats , -1 , "sf_get_event_stats fail , invalid stats pointer %p", stats);
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_get_event_stats fail , invalid handle value : %d",handle);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
 		errno = EINVAL;
 		return -1;
 	}
-	
 
-	INFO("Sensor S/F unregister cb\n");
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_REG);
-	packet.set_payload_size(sizeof(cmd_reg_t));	
-	payload->type = REG_DEL; 
-	payload->event_type = event_type;
+	io_lock();
+	memcpy(stats, &g_cb_info[cb_number].stats, sizeof(sensor_event_stats_t));
+	stats->queued = g_cb_table[cb_number].collected_num;
+	io_unlock();
 
-	switch (event_type ) {
-		case ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case ACCELEROMETER_EVENT_LINEAR_ACCELERATION_DATA_REPORT_ON_TIME :
-			/* fall through */ 
-		case GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME:
-			/* fall through */ 			
-		case PROXIMITY_EVENT_STATE_REPORT_ON_TIME:
-			/* fall through */
-		case GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case BAROMETER_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case BAROMETER_EVENT_TEMPERATURE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case BAROMETER_EVENT_ALTITUDE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case LIGHT_EVENT_LEVEL_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case FUSION_SENSOR_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case FUSION_ROTATION_VECTOR_EVENT_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case FUSION_ROTATION_MATRIX_EVENT_DATA_REPORT_ON_TIME:
-			collect_data_flag = 1;				
-			break;
+	return 0;
+}
+
+EXTAPI int sf_set_event_priority(int handle, unsigned int event_type, int priority)
+{
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_event_priority fail , invalid handle value : %d",handle);
+	retvm_if( (priority < SENSOR_PRIORITY_DEFAULT) || (priority > SENSOR_PRIORITY_LOW) , -1 , "sf_set_event_priority fail , invalid priority : %d", priority);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
 	}
 
-	INFO("Send CMD_REG command\n");
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Faield to send a packet\n");		
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("event_type [%x] is not a report on time event", event_type);
+		errno = EINVAL;
+		return -1;
 	}
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Failed to recv packet_header\n");
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
+	/* queued samples follow the subscription into its new class */
+	io_lock();
+	queue_account(cb_number, -(int)g_cb_table[cb_number].collected_num);
+	g_cb_table[cb_number].priority = priority;
+	queue_account(cb_number, (int)g_cb_table[cb_number].collected_num);
+	io_unlock();
+
+	return 0;
+}
+
+EXTAPI int sf_set_event_batch(int handle, unsigned int event_type, unsigned int max_latency)
+{
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+	unsigned int depth;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_event_batch fail , invalid handle value : %d",handle);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
 	}
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			ERR("Failed to recv packet\n");			
-			release_handle(handle);
-			errno = ECOMM;
-			return -2;
-		}
-	}	
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("event_type [%x] is not a report on time event", event_type);
+		errno = EINVAL;
+		return -1;
+	}
 
-	if ( collect_data_flag ) {
-		g_source_destroy(g_cb_table[find_cb_handle].source);
-		g_source_unref(g_cb_table[find_cb_handle].source);
-		g_cb_table[find_cb_handle].request_count = 0;
-		g_cb_table[find_cb_handle].request_data_id = 0;
-		g_cb_table[find_cb_handle].gsource_interval = 0;
-	} else {
-		for(j = 0 ; j < MAX_EVENT_LIST ; j++){
-			if(g_event_list[j].event_type == event_type){
-				if(g_event_list[j].event_counter <= 1){
-					state = vconf_ignore_key_changed(g_cb_table[find_cb_handle].call_back_key, sensor_changed_cb);
-					if ( state < 0 ) {
-						ERR("Failed to del callback using by vconf_del_changed_cb for key : %s\n",g_cb_table[find_cb_handle].call_back_key);
-						errno = ENODEV;
-						state = -2;
-					}
-					else {
-						DBG("del callback using by vconf success");
-					}
-				} else {
-					DBG("fake remove");
-				}
-				del_cb_number(j,find_cb_handle);
-			}
+	/* a batch holds every sample taken within the latency budget, plus the one closing it */
+	depth = (max_latency / g_cb_table[cb_number].gsource_interval) + 1;
+	if (depth > MAX_ON_TIME_REQUEST_COUNTER)
+		depth = MAX_ON_TIME_REQUEST_COUNTER;
+
+	io_lock();
+	if (max_latency && depth > g_cb_table[cb_number].request_count) {
+		if (queue_alloc(cb_number, depth, g_cb_table[cb_number].queue_policy) < 0) {
+			io_unlock();
+			errno = ENOMEM;
+			return -2;
 		}
 	}
 
-	cb_release_handle(find_cb_handle);
-	g_bind_table[handle].cb_slot_num[i] = -1;
+	/* samples already queued move between the batch and the delivery source */
+	queue_account(cb_number, -(int)g_cb_table[cb_number].collected_num);
+	g_cb_table[cb_number].batch_latency = max_latency;
+	g_cb_table[cb_number].batch_deadline = ctimer_wheel::now() + max_latency;
+	queue_account(cb_number, (int)g_cb_table[cb_number].collected_num);
 
-	return state;
-}
+	/* samples already queued open the batch */
+	if (max_latency && g_cb_table[cb_number].collected_num)
+		batch_timer_arm(cb_number);
+	else
+		batch_timer_cancel(cb_number);
+	io_unlock();
 
+	return 0;
+}
 
-EXTAPI int sf_get_data(int handle , unsigned int data_id ,  sensor_data_t* values)
+EXTAPI int sf_set_event_adaptive(int handle, unsigned int event_type, unsigned int max_interval, float threshold)
 {
-	cpacket packet(sizeof(cmd_get_struct_t)+sizeof(base_data_struct)+4);
-	cmd_get_data_t *payload;
-	cmd_get_struct_t *return_payload;
-	int i;
-	struct timeval sv;	
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+	guint base;
 
-	
-	retvm_if( (!values) , -1 , "sf_get_data fail , invalid get_values pointer %p", values);
-	retvm_if( ( (data_id & 0xFFFF) < 1) || ( (data_id & 0xFFFF) > 0xFFF), -1 , "sf_get_data fail , invalid data_id %d", data_id);
-	retvm_if( handle > MAX_BIND_SLOT , -1 , "Incorrect handle");
-	retvm_if( (g_bind_table[handle].ipc == NULL) ||(handle < 0) , -1 , "sf_get_data fail , invalid handle value : %d",handle);
- 
-	if(g_bind_table[handle].sensor_state != SENSOR_STATE_STARTED)
-	{
-		ERR("sensor framewoker doesn't started");
-		values->data_accuracy = SENSOR_ACCURACY_UNDEFINED;
-		values->data_unit_idx = SENSOR_UNDEFINED_UNIT;
-		values->time_stamp = 0;
-		values->values_num = 0;
-		errno = ECOMM;
-		return -2;
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_event_adaptive fail , invalid handle value : %d",handle);
+	retvm_if( threshold < 0 , -1 , "sf_set_event_adaptive fail , invalid threshold : %f", threshold);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
 	}
 
-	payload = (cmd_get_data_t*)packet.data();
-	if (!payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		return -2;
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("event_type [%x] is not a report on time event", event_type);
+		errno = EINVAL;
+		return -1;
 	}
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_GET_STRUCT);
-	packet.set_payload_size(sizeof(cmd_get_data_t));
-	payload->data_id = data_id;
+	base = g_cb_table[cb_number].adaptive_interval ? g_cb_info[cb_number].adaptive_base : g_cb_table[cb_number].gsource_interval;
+	retvm_if( max_interval && (max_interval < base) , -1 , "sf_set_event_adaptive fail , max_interval %u below interval %u", max_interval, base);
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {		
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
-	}
+	io_lock();
+	g_cb_info[cb_number].adaptive_base = base;
+	g_cb_info[cb_number].adaptive_threshold = threshold;
+	g_cb_info[cb_number].adaptive_still = 0;
+	g_cb_info[cb_number].adaptive_ref_set = 0;
+	g_cb_info[cb_number].adaptive_next = 0;
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		release_handle(handle);
-		errno = ECOMM;
-		return -2;
-	}
+	g_cb_table[cb_number].adaptive_interval = max_interval;
+	io_unlock();
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			release_handle(handle);
-			errno = ECOMM;
+	/* leaving adaptive mode goes back to the asked rate */
+	if (!max_interval && g_cb_table[cb_number].gsource_interval != base) {
+		if (server_post_reg(slot, event_type, base) < 0)
 			return -2;
-		}
+
+		io_lock();
+		g_cb_table[cb_number].gsource_interval = base;
+		stream_refresh(g_cb_table[cb_number].stream_slot);
+		io_unlock();
 	}
 
-	return_payload = (cmd_get_struct_t*)packet.data();
-	if (!return_payload) {
-		ERR("cannot find memory for return packet.data");
-		errno = ENOMEM;
-		return -2;
+	return 0;
+}
+
+EXTAPI int sf_set_event_tolerance(int handle, unsigned int event_type, unsigned int tolerance)
+{
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_event_tolerance fail , invalid handle value : %d",handle);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
+		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
 	}
 
-	if ( return_payload->state < 0 ) {
-		ERR("get values fail from server \n");
-		values->data_accuracy = SENSOR_ACCURACY_UNDEFINED;
-		values->data_unit_idx = SENSOR_UNDEFINED_UNIT;
-		values->time_stamp = 0;
-		values->values_num = 0;
-		errno = ECOMM;
-		return -2;
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("event_type [%x] is not a report on time event", event_type);
+		errno = EINVAL;
+		return -1;
 	}
 
-	base_data_struct *base_return_data;
-	base_return_data = (base_data_struct *)return_payload->data_struct;
+	io_lock();
+	g_cb_info[cb_number].tolerance = tolerance;
+	stream_refresh(g_cb_table[cb_number].stream_slot);
+	io_unlock();
 
-	gettimeofday(&sv, NULL);
-	values->time_stamp = MICROSECONDS(sv);
+	return 0;
+}
 
-	values->data_accuracy = base_return_data->data_accuracy;
-	values->data_unit_idx = base_return_data->data_unit_idx;
-	values->values_num = base_return_data->values_num;
-	for ( i = 0 ; i <  base_return_data->values_num ; i++ ) {
-		values->values[i] = base_return_data->values[i];
-		DBG("client , get_data_value , [%d] : %f \n", i , values->values[i]);
+EXTAPI int sf_get_lib_stats(sensor_lib_stats_t *stats)
+{
+	sf_loop_table_t *loop;
+	int i;
+
+	retvm_if( !stats , -1 , "sf_get_lib_stats fail , invalid stats pointer %p", stats);
+
+	memset(stats, 0, sizeof(sensor_lib_stats_t));
+	for (i = 0; i < MAX_LOOP_SLOT; i++) {
+		stats->wakeups += g_loop_table[i].wheel.wakeups();
+		stats->wakeups_saved += g_loop_table[i].wheel.wakeups_saved();
+		stats->io_dropped += g_loop_table[i].io_dropped;
+	}
+
+	if (g_rt_slot >= 0) {
+		loop = &g_loop_table[g_rt_slot];
+		io_lock();
+		stats->rt_ticks = loop->rt_ticks;
+		stats->rt_jitter_max_us = loop->rt_jitter_max_us;
+		stats->rt_jitter_avg_us = loop->rt_ticks ? (unsigned int)(loop->rt_jitter_sum_us / loop->rt_ticks) : 0;
+		io_unlock();
 	}
-	
 
 	return 0;
-	
 }
 
-EXTAPI int sf_check_rotation( unsigned long *curr_state)
+EXTAPI int sf_connect_async(sensor_type_t sensor_type, sensor_connect_cb_t cb, void *user_data)
 {
-	int state = -1;
+	sf_connect_req_t *req;
+	pthread_attr_t attr;
+	pthread_t thread;
+	const char *sf_channel_name = NULL;
+	int i;
 
-	double raw_z;
-	double atan_value = 0, norm_z = 0;
-	int acc_theta = 0 , acc_pitch = 0;
-	int handle = 0;
-	int lcd_type = 0;
+	retvm_if( !cb , -1 , "sf_connect_async fail , no callback for sensor_type : %x", sensor_type);
+
+	INFO("Sensor_attach_channel async from pid : %d , to sensor_type : %x",getpid() ,sensor_type);
+
+	i = bind_prepare(sensor_type, &sf_channel_name);
+	if (i < 0)
+		return i;
+
+	req = (sf_connect_req_t *)malloc(sizeof(sf_connect_req_t));
+	if (!req) {
+		ERR("cannot find memory for connect request");
+		release_handle(i);
+		errno = ENOMEM;
+		return -2;
+	}
 
-	sensor_data_t *base_data_values = (sensor_data_t*)malloc(sizeof(sensor_data_t));
+	req->slot = i;
+	req->handle = g_bind_table[i].my_handle;
+	req->channel_name = sf_channel_name;
+	req->cb = cb;
+	req->user_data = user_data;
+	req->ipc = NULL;
+	req->ret = 0;
+	req->err = 0;
+
+	/* the handshake blocks on the socket, so it runs on its own thread and reports back through the main loop */
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&thread, &attr, connect_async_worker, req) != 0) {
+		ERR("Failed to create connect thread\n");
+		pthread_attr_destroy(&attr);
+		free(req);
+		release_handle(i);
+		errno = EAGAIN;
+		return -2;
+	}
+	pthread_attr_destroy(&attr);
 
-	retvm_if( curr_state==NULL , -1 , "sf_check_rotation fail , invalid curr_state");
+	return 0;
+}
 
-	*curr_state = ROTATION_UNKNOWN;
-	
-	INFO("Sensor_attach_channel from pid : %d",getpid());
-	
-	handle = sf_connect( ACCELEROMETER_SENSOR);
-	if (handle<0)
-	{
-		ERR("sensor attach fail\n");
-		return 0;
-	}
+EXTAPI int sf_get_event_fd(void)
+{
+	struct epoll_event ev;
+	int i;
 
-	state = sf_start(handle, 0);
-	if(state < 0)
-	{
-		ERR("sf_start fail\n");
-		return 0;
-	}
+	if (g_event_fd >= 0)
+		return g_event_fd;
 
-	state = sf_get_data(handle, ACCELEROMETER_BASE_DATA_SET, base_data_values);
-	if(state < 0)
-	{
-		ERR("sf_get_data fail\n");
-		return 0;
+	if (!g_loop_table[0].wheel.init()) {
+		ERR("cannot create timer wheel");
+		errno = ENOMEM;
+		return -2;
 	}
 
-	state = sf_stop(handle);
-	if(state < 0)
-	{
-		ERR("sf_stop fail\n");
-		return 0;
+	g_event_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (g_event_fd < 0) {
+		ERR("epoll_create1 fail , errno : %d\n", errno);
+		return -2;
 	}
 
-	state = sf_disconnect(handle);
-	if(state < 0)
-	{
-		ERR("sf_disconnect fail\n");
-		return 0;
+	g_event_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (g_event_notify_fd < 0) {
+		ERR("eventfd fail , errno : %d\n", errno);
+		close(g_event_fd);
+		g_event_fd = -1;
+		return -2;
 	}
 
-	if((base_data_values->values[0] > XY_POSITIVE_THD || base_data_values->values[0] < XY_NEGATIVE_THD) || (base_data_values->values[1] > XY_POSITIVE_THD || base_data_values->values[1] < XY_NEGATIVE_THD))
-	{
-		atan_value = atan2(-(base_data_values->values[1]),(base_data_values->values[0]));
-		acc_theta = ((int)(atan_value * (RADIAN_VALUE) + 270.0))%360;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
 
-		raw_z = (double)(base_data_values->values[2]) / 9.8;
+	ev.data.fd = g_loop_table[0].wheel.get_fd();
+	if (epoll_ctl(g_event_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0)
+		goto fail;
 
-		if ( raw_z > 1.0 ) {
-			norm_z = 1.0;
-		}
-		else if ( raw_z < -1.0 ) {
-			norm_z = -1.0;
-		}
-		else {
-			norm_z = raw_z;
-		}
-		acc_pitch = (int)( acos(norm_z) *(RADIAN_VALUE));
-	}
+	ev.data.fd = g_event_notify_fd;
+	if (epoll_ctl(g_event_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0)
+		goto fail;
 
-	INFO( "cal value [acc_theta] : %d , [acc_pitch] : %d\n",acc_theta ,acc_pitch);
+	if (g_loop_table[0].io_source) {
+		ev.data.fd = g_loop_table[0].io_notify_fd;
+		if (epoll_ctl(g_event_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0)
+			goto fail;
+	}
 
-	if( (acc_pitch>PITCH_MIN) && (acc_pitch<PITCH_MAX) ) {
-		if ((acc_theta >= ROTATION_360 - ROTATION_THD && acc_theta <= ROTATION_360 ) ||	(acc_theta >= ROTATION_0 && acc_theta < ROTATION_0 + ROTATION_THD))
-		{
-			*curr_state = rotation_mode[ROTATION_EVENT_0].rm[lcd_type];	
-		}
-		else if(acc_theta >= ROTATION_90 - ROTATION_THD && acc_theta < ROTATION_90 + ROTATION_THD)
-		{
-			*curr_state = rotation_mode[ROTATION_EVENT_90].rm[lcd_type];
-		}
-		else if(acc_theta >= ROTATION_180 - ROTATION_THD && acc_theta < ROTATION_180 + ROTATION_THD)
-		{
-			*curr_state = rotation_mode[ROTATION_EVENT_180].rm[lcd_type];
-		}
-		else if(acc_theta >= ROTATION_270 - ROTATION_THD && acc_theta < ROTATION_270 + ROTATION_THD)
-		{
-			*curr_state = rotation_mode[ROTATION_EVENT_270].rm[lcd_type];	
-		} 
-		else {
-			ERR("Wrong acc_theta : %d , cannot detect current state of ACCEL_SENSOR",acc_theta);
-			*curr_state = rotation_mode[ROTATION_UNKNOWN].rm[lcd_type];
-		}		
-	}else {
-		INFO("Cannot detect current state of ACCEL_SENSOR");
-		*curr_state = rotation_mode[ROTATION_UNKNOWN].rm[lcd_type];
-	}			
-	
-	state = 0;	
-	if(base_data_values)
-	{
-		free(base_data_values);
-		base_data_values = NULL;
+	/* samples queued before the fd existed must wake the application too */
+	for (i = 0; i < SENSOR_PRIORITY_NUM; i++) {
+		if (g_loop_table[0].delivery_pending[i])
+			event_notify();
 	}
 
-	return state;
+	INFO("Event fd : %d\n", g_event_fd);
+	return g_event_fd;
 
+fail:
+	ERR("epoll_ctl fail , errno : %d\n", errno);
+	close(g_event_notify_fd);
+	g_event_notify_fd = -1;
+	close(g_event_fd);
+	g_event_fd = -1;
+	return -2;
 }
 
 
-EXTAPI int sf_set_wakeup(sensor_type_t sensor_type)
+EXTAPI int sf_dispatch_pending(int max)
 {
-	int i = 0;
+	unsigned long long count;
+	int dispatched = 0;
+	int delivered;
+	int priority_class;
+	int i;
 
-	if(sf_is_wakeup_supported(sensor_type) < 0)
-	{
-		ERR("Cannot support wake up");
-		return -1;
+	retvm_if( g_event_fd < 0 , -1 , "sf_dispatch_pending fail , no event fd, sf_get_event_fd() was not called");
+
+	if (read(g_event_notify_fd, &count, sizeof(count)) == sizeof(count))
+		g_event_notified = 0;
+
+	/* expired streams fill the queues, and batches are delivered right away */
+	if (g_io_thread_on) {
+		io_ring_drain(0);
+	} else {
+		g_loop_table[0].wheel.run(0);
+		stream_fetch_flush(0);
 	}
 
-	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
-	{
-		if(g_bind_table[i].sensor_type == sensor_type)
-		{
-			g_bind_table[i].wakeup_state = SENSOR_WAKEUP_SETTED;
+	for (i = 0; i < SENSOR_PRIORITY_NUM && (max <= 0 || dispatched < max); i++) {
+		priority_class = g_delivery_order[i];
+
+		while (g_loop_table[0].delivery_pending[priority_class] && (max <= 0 || dispatched < max)) {
+			delivered = delivery_dispatch(0, priority_class, (max > 0) ? max - dispatched : 0);
+			if (!delivered)
+				break;
+			dispatched += delivered;
 		}
 	}
 
-	vconf_notify_key_changed(VCONFKEY_PM_STATE, lcd_off_set_wake_up, NULL);
+	/* keep the fd readable while samples are left for the next call */
+	for (i = 0; i < SENSOR_PRIORITY_NUM; i++) {
+		if (g_loop_table[0].delivery_pending[i])
+			event_notify();
+	}
 
-	return 0;
+	return dispatched;
 }
 
-EXTAPI int sf_unset_wakeup(sensor_type_t sensor_type)
+EXTAPI int sf_set_main_context(int handle, GMainContext *context)
 {
-	int i = 0;
+	int slot;
+	int loop_slot;
 
-	if(sf_is_wakeup_supported(sensor_type) < 0)
-	{
-		ERR("Cannot support wake up");
-		return -1;
-	}
-	
-	if(sensor_type == ACCELEROMETER_SENSOR)
-		return sf_set_property(sensor_type, ACCELEROMETER_PROPERTY_SET_WAKEUP, WAKEUP_UNSET);
-	else
-	{
-		ERR("Cannot support wakeup");
-		return -1;
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_main_context fail , invalid handle value : %d",handle);
+
+	loop_slot = loop_acquire(context);
+	if (loop_slot < 0) {
+		errno = ENOMEM;
+		return -2;
 	}
-	
-	for(i = 0 ; i < MAX_BIND_SLOT ; i++)
-	{
-		if(g_bind_table[i].sensor_type == sensor_type)
-		{
-			g_bind_table[i].wakeup_state = SENSOR_WAKEUP_UNSETTED;
-		}
+
+	if (loop_slot == g_bind_table[slot].loop_slot) {
+		loop_release(loop_slot);
+		return 0;
 	}
 
-	vconf_ignore_key_changed(VCONFKEY_PM_STATE, lcd_off_set_wake_up);
+	bind_move_loop(slot, loop_slot);
 
+	INFO("handle [%d] served by main context slot [%d]\n", handle, loop_slot);
 	return 0;
 }
 
-EXTAPI int sf_is_wakeup_supported(sensor_type_t sensor_type)
+EXTAPI int sf_set_io_thread(int enable)
 {
-	if(sensor_type == ACCELEROMETER_SENSOR)
-		return sf_set_property(sensor_type, ACCELEROMETER_PROPERTY_CHECK_WAKEUP_SUPPORTED,	WAKEUP_SET);
-	else
-	{
-		ERR("Cannot support wakeup");
-		return -1;
+	int i;
+
+	enable = enable ? 1 : 0;
+	if (enable == g_io_thread_on)
+		return 0;
+
+	for (i = 0; i < MAX_STREAM_SLOT; i++) {
+		if (g_stream_table[i].subscriber_num > 0 && g_stream_table[i].tick_interval) {
+			ERR("sf_set_io_thread fail , stream [%d] for data_id [%x] is running\n", i, g_stream_table[i].data_id);
+			errno = EBUSY;
+			return -1;
+		}
 	}
-}
 
-EXTAPI int sf_is_wakeup_enabled(sensor_type_t sensor_type)
-{
-	if(sensor_type == ACCELEROMETER_SENSOR)
-		return sf_set_property(sensor_type,ACCELEROMETER_PROPERTY_CHECK_WAKEUP_STATUS,0);
-	else
-	{
-		 ERR("Cannot support wakeup");
-		 return -1;
+	if (!enable) {
+		io_thread_stop_wait(1);
+	} else if (io_thread_start() < 0) {
+		return -2;
 	}
+
+	/* started handles get or give back the connection of the thread */
+	for (i = 0; i < MAX_BIND_SLOT; i++) {
+		if (g_bind_table[i].my_handle > 0)
+			bind_io_sync(i);
+	}
+
+	INFO("I/O thread %s\n", enable ? "started" : "stopped");
+	return 0;
 }
 
-EXTAPI int sf_change_event_condition(int handle, unsigned int event_type, event_condition_t *event_condition)
+EXTAPI int sf_set_rt_delivery(int handle, int priority, int cpu)
 {
-	cpacket packet(sizeof(cmd_reg_t) + 4);
-	cmd_reg_t *payload;
-	int sensor_state = SENSOR_STATE_UNKNOWN;
+	int slot;
+	int loop_slot;
 
-	int i = 0;
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_rt_delivery fail , invalid handle value : %d",handle);
+	retvm_if( priority < sched_get_priority_min(SCHED_FIFO) || priority > sched_get_priority_max(SCHED_FIFO) , -1 ,
+		"sf_set_rt_delivery fail , invalid priority : %d", priority);
+	retvm_if( cpu >= CPU_SETSIZE , -1 , "sf_set_rt_delivery fail , invalid cpu : %d", cpu);
 
-	switch (event_type ) {
-		case ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case ACCELEROMETER_EVENT_ORIENTATION_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case ACCELEROMETER_EVENT_LINEAR_ACCELERATION_DATA_REPORT_ON_TIME :
-			/* fall through */
-		case GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case PROXIMITY_EVENT_STATE_REPORT_ON_TIME:
-			/* fall through */
-		case GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case BAROMETER_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case BAROMETER_EVENT_TEMPERATURE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case BAROMETER_EVENT_ALTITUDE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case LIGHT_EVENT_LEVEL_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case FUSION_SENSOR_EVENT_RAW_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case FUSION_ROTATION_VECTOR_EVENT_DATA_REPORT_ON_TIME:
-			/* fall through */
-		case FUSION_ROTATION_MATRIX_EVENT_DATA_REPORT_ON_TIME:
-			break;
-		default :
-			ERR("Cannot support this API");
-			return -1;
+	loop_slot = rt_loop_acquire(priority, cpu);
+	if (loop_slot < 0)
+		return -2;
+
+	if (loop_slot == g_bind_table[slot].loop_slot) {
+		loop_release(loop_slot);
+		return 0;
 	}
 
-	for(i = 0 ; i < MAX_CB_SLOT_PER_BIND ; i++)
-	{
-		if(g_cb_table[g_bind_table[handle].cb_slot_num[i]].cb_event_type == event_type)
-		{
-			if(!event_condition)
-			{
-				if(g_cb_table[g_bind_table[handle].cb_slot_num[i]].gsource_interval == (guint)BASE_GATHERING_INTERVAL)
-				{
-					ERR("same interval");
-					return -1;
-				}
-			}
-			else
-			{
-				if(g_cb_table[g_bind_table[handle].cb_slot_num[i]].gsource_interval == (guint)event_condition->cond_value1)
-				{
-					ERR("same interval");
-					return -1;
-				}
-			}
+	bind_move_loop(slot, loop_slot);
 
-			DBG("find callback number [%d]",i);
-			break;
-		}
-	}
+	INFO("handle [%d] served by the real-time thread, priority %d cpu %d\n", handle, priority, cpu);
+	return 0;
+}
 
-	if(i == MAX_CB_SLOT_PER_BIND)
-	{
+EXTAPI int sf_set_event_executor(int handle, unsigned int event_type, int enable)
+{
+	int slot;
+	int cb_slot_idx;
+	int cb_number;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_set_event_executor fail , invalid handle value : %d",handle);
+
+	cb_slot_idx = event_find_cb_slot(slot, event_type);
+	if (cb_slot_idx < 0) {
 		ERR("cannot find event_type [%x] in handle [%d]", event_type, handle);
+		errno = EINVAL;
 		return -1;
 	}
 
-	sensor_state = g_bind_table[handle].sensor_state;
-	g_bind_table[handle].sensor_state = SENSOR_STATE_STOPPED;
+	cb_number = g_bind_info[slot].cb_slot_num[cb_slot_idx];
+	if (!g_cb_table[cb_number].request_data_id) {
+		ERR("event_type [%x] is not a report on time event", event_type);
+		errno = EINVAL;
+		return -1;
+	}
 
-	payload = (cmd_reg_t*)packet.data();
-	if(payload) {
-		ERR("cannot find memory for send packet.data");
-		errno = ENOMEM;
-		g_bind_table[handle].sensor_state = SENSOR_STATE_STARTED;
-		return -2;
+	if (!enable) {
+		exec_cancel(cb_number);
+		return 0;
 	}
 
-	packet.set_version(PROTOCOL_VERSION);
-	packet.set_cmd(CMD_REG);
-	packet.set_payload_size(sizeof(cmd_reg_t));
-	payload->type = REG_ADD;
-	payload->event_type = event_type;
+	if (!g_exec_worker_num && exec_start() < 0)
+		return -2;
 
-	if(!event_condition)
-		payload->interval = BASE_GATHERING_INTERVAL;
-	else if((event_condition->cond_op == CONDITION_EQUAL) && (event_condition->cond_value1 > 0 ))
-		payload->interval = event_condition->cond_value1;
-	else
-		payload->interval = BASE_GATHERING_INTERVAL;
+	io_lock();
+	g_cb_table[cb_number].exec = 1;
+	io_unlock();
+	return 0;
+}
 
+EXTAPI int sf_record_start(int handle, unsigned int event_type, const char *path)
+{
+	int cb_list[MAX_CB_SLOT_PER_BIND];
+	int cb_num;
+	int record_slot;
+	int slot;
+	int j;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_record_start fail , invalid handle value : %d",handle);
+	retvm_if( !path , -1 , "sf_record_start fail , invalid path");
+
+	cb_num = record_find_cb(slot, event_type, cb_list);
+	if (!cb_num) {
+		ERR("no report on time event [%x] registered in handle [%d]", event_type, handle);
+		errno = EINVAL;
+		return -1;
+	}
 
-	INFO("Send CMD_REG command with reg_type : %x , event_type : %x\n",payload->type , payload->event_type );
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->send(packet.packet(), packet.size()) == false) {
-		ERR("Faield to send a packet\n");
-		errno = ECOMM;
-		g_bind_table[handle].sensor_state = sensor_state;
-		return -2;
+	for (j = 0; j < cb_num; j++) {
+		if (g_cb_table[cb_list[j]].record_slot >= 0) {
+			ERR("event_type [%x] of handle [%d] is already recorded", g_cb_table[cb_list[j]].cb_event_type, handle);
+			errno = EBUSY;
+			return -1;
+		}
 	}
 
-	if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv(packet.packet(), packet.header_size()) == false) {
-		ERR("Faield to receive a packet\n");
-		errno = ECOMM;
-		g_bind_table[handle].sensor_state = sensor_state;
+	record_slot = record_open(path);
+	if (record_slot < 0)
 		return -2;
-	}
 
-	if (packet.payload_size()) {
-		if (g_bind_table[handle].ipc && g_bind_table[handle].ipc->recv((char*)packet.packet() + packet.header_size(), packet.payload_size()) == false) {
-			ERR("Faield to receive a packet\n");
-			errno = ECOMM;
-			g_bind_table[handle].sensor_state = sensor_state;
-			return -2;
-		}
+	if (g_loop_table[g_bind_table[slot].loop_slot].rt)
+		record_lock(record_slot);
 
-		if (packet.cmd() == CMD_DONE) {
-			cmd_done_t *payload;
-			payload = (cmd_done_t*)packet.data();
-			if (payload->value == -1) {
-				ERR("server register fail\n");
-				errno = ECOMM;
-				g_bind_table[handle].sensor_state = sensor_state;
-				return -2;
-			}
-		} else {
-			ERR("unexpected server cmd\n");
-			errno = ECOMM;
-			g_bind_table[handle].sensor_state = sensor_state;
-			return -2;
-		}
+	io_lock();
+	for (j = 0; j < cb_num; j++) {
+		g_cb_table[cb_list[j]].record_slot = record_slot;
+		g_cb_info[cb_list[j]].record_chunk = -1;
+		g_record_table[record_slot].cb_num++;
 	}
+	io_unlock();
+
+	INFO("handle [%d] recorded to %s\n", handle, path);
+	return 0;
+}
 
-	g_source_destroy(g_cb_table[i].source);
-	g_source_unref(g_cb_table[i].source);
+EXTAPI int sf_record_stop(int handle, unsigned int event_type)
+{
+	int cb_list[MAX_CB_SLOT_PER_BIND];
+	int cb_num;
+	int slot;
+	int stopped = 0;
+	int j;
+
+	slot = handle_to_slot(handle);
+	retvm_if( slot < 0 , -1 , "sf_record_stop fail , invalid handle value : %d",handle);
+
+	cb_num = record_find_cb(slot, event_type, cb_list);
+
+	io_lock();
+	for (j = 0; j < cb_num; j++) {
+		if (g_cb_table[cb_list[j]].record_slot < 0)
+			continue;
 
-	g_cb_table[i].gsource_interval = (guint)payload->interval;
-	g_cb_table[i].source = g_timeout_source_new(g_cb_table[i].gsource_interval);
-	g_source_set_callback (g_cb_table[i].source, sensor_timeout_handler, (gpointer)&g_cb_table[i].my_cb_handle,NULL);
-	g_cb_table[i].gID = g_source_attach (g_cb_table[i].source, NULL);
+		record_detach(cb_list[j]);
+		stopped++;
+	}
+	io_unlock();
 
-	g_bind_table[handle].sensor_state = sensor_state;
+	if (!stopped) {
+		ERR("event_type [%x] of handle [%d] is not recorded", event_type, handle);
+		errno = EINVAL;
+		return -1;
+	}
 
 	return 0;
 }
@@ -0,0 +1,408 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#include <sys/types.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <common.h>
+
+#include "ctimer_wheel.h"
+
+#define EXPIRY_NONE		(~0ULL)
+#define MAX_TIMEOUT_TICK	((1ULL << (ctimer_wheel::LEVEL_BITS * ctimer_wheel::LEVEL_NUM)) - 1)
+
+ctimer_wheel::entry::entry()
+: prev(0)
+, next(0)
+, expires(0)
+, slack(0)
+, level(-1)
+, slot(-1)
+, cb(0)
+, user_data(0)
+{
+}
+
+ctimer_wheel::ctimer_wheel()
+: m_fd(-1)
+, m_clock(now)
+, m_current(0)
+, m_armed_expiry(EXPIRY_NONE)
+, m_count(0)
+, m_wakeups(0)
+, m_wakeups_saved(0)
+{
+	int i, j;
+
+	for (i = 0; i < LEVEL_NUM; i++) {
+		m_bitmap[i] = 0;
+		for (j = 0; j < LEVEL_SIZE; j++)
+			list_init(&m_slot[i][j]);
+	}
+
+	list_init(&m_pending);
+}
+
+ctimer_wheel::~ctimer_wheel()
+{
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+bool ctimer_wheel::init(void)
+{
+	if (m_fd >= 0)
+		return true;
+
+	m_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (m_fd < 0) {
+		ERR("timerfd_create fail , errno : %d\n", errno);
+		return false;
+	}
+
+	m_current = m_clock();
+	m_armed_expiry = EXPIRY_NONE;
+
+	return true;
+}
+
+unsigned long long ctimer_wheel::now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((unsigned long long)ts.tv_sec * 1000ULL) + (ts.tv_nsec / 1000000);
+}
+
+void ctimer_wheel::list_init(entry *head)
+{
+	head->prev = head;
+	head->next = head;
+}
+
+bool ctimer_wheel::list_empty(entry *head)
+{
+	return head->next == head;
+}
+
+void ctimer_wheel::list_add_tail(entry *head, entry *e)
+{
+	e->prev = head->prev;
+	e->next = head;
+	head->prev->next = e;
+	head->prev = e;
+}
+
+void ctimer_wheel::list_del(entry *e)
+{
+	e->prev->next = e->next;
+	e->next->prev = e->prev;
+	e->prev = 0;
+	e->next = 0;
+}
+
+unsigned long long ctimer_wheel::coalesce(unsigned long long expires, unsigned int slack)
+{
+	const unsigned long long latest = expires + slack;
+	unsigned long long first, last, span;
+	unsigned long long best = EXPIRY_NONE;
+	entry *head;
+	entry *e;
+	int level;
+	int slot;
+
+	if (!slack)
+		return expires;
+
+	/* join the wakeup already armed when it falls within the slack */
+	if ((m_armed_expiry != EXPIRY_NONE) && (m_armed_expiry >= expires) && (m_armed_expiry <= latest))
+		return m_armed_expiry;
+
+	/* otherwise join the earliest entry due within the slack, whatever its level */
+	for (level = 0; level < LEVEL_NUM; level++) {
+		if (!m_bitmap[level])
+			continue;
+
+		first = expires >> (LEVEL_BITS * level);
+		last = latest >> (LEVEL_BITS * level);
+		span = last - first + 1;
+		if (span > LEVEL_SIZE)
+			span = LEVEL_SIZE;
+
+		for (; span > 0; span--, first++) {
+			slot = (int)(first & LEVEL_MASK);
+			if (!(m_bitmap[level] & (1ULL << slot)))
+				continue;
+
+			head = &m_slot[level][slot];
+			for (e = head->next; e != head; e = e->next) {
+				if ((e->expires >= expires) && (e->expires <= latest) && (e->expires < best))
+					best = e->expires;
+			}
+		}
+	}
+
+	return (best != EXPIRY_NONE) ? best : expires;
+}
+
+void ctimer_wheel::place(entry *e)
+{
+	unsigned long long delta;
+	int level = 0;
+
+	if (e->expires < m_current)
+		e->expires = m_current;
+
+	delta = e->expires - m_current;
+	if (delta > MAX_TIMEOUT_TICK) {
+		e->expires = m_current + MAX_TIMEOUT_TICK;
+		delta = MAX_TIMEOUT_TICK;
+	}
+
+	while ((level < LEVEL_NUM - 1) && (delta >> (LEVEL_BITS * (level + 1))))
+		level++;
+
+	e->level = level;
+	e->slot = (int)((e->expires >> (LEVEL_BITS * level)) & LEVEL_MASK);
+
+	list_add_tail(&m_slot[level][e->slot], e);
+	m_bitmap[level] |= (1ULL << e->slot);
+}
+
+void ctimer_wheel::add(entry *e, unsigned int timeout_ms)
+{
+	add_at(e, m_clock() + timeout_ms);
+}
+
+void ctimer_wheel::add_at(entry *e, unsigned long long expires)
+{
+	unsigned long long t;
+
+	if (e->is_armed())
+		cancel(e);
+
+	/* an idle wheel is not advanced, catch up before placing relative to m_current */
+	if (!m_count && list_empty(&m_pending)) {
+		t = m_clock();
+		if (t > m_current)
+			m_current = t;
+	}
+
+	e->expires = coalesce(expires, e->slack);
+	place(e);
+	m_count++;
+
+	if (e->expires < m_armed_expiry)
+		arm();
+}
+
+void ctimer_wheel::cancel(entry *e)
+{
+	if (!e->is_armed())
+		return;
+
+	list_del(e);
+	m_count--;
+
+	if ((e->level >= 0) && list_empty(&m_slot[e->level][e->slot]))
+		m_bitmap[e->level] &= ~(1ULL << e->slot);
+
+	e->level = -1;
+	e->slot = -1;
+}
+
+void ctimer_wheel::reschedule(entry *e, unsigned int timeout_ms)
+{
+	cancel(e);
+	add(e, timeout_ms);
+}
+
+void ctimer_wheel::cascade(int level)
+{
+	const int slot = (int)((m_current >> (LEVEL_BITS * level)) & LEVEL_MASK);
+	entry *head = &m_slot[level][slot];
+	entry *e;
+
+	m_bitmap[level] &= ~(1ULL << slot);
+
+	while (!list_empty(head)) {
+		e = head->next;
+		list_del(e);
+		place(e);
+	}
+}
+
+bool ctimer_wheel::advance(unsigned long long target)
+{
+	unsigned long long bits;
+	unsigned long long step;
+	entry *head;
+	int idx;
+	int level;
+	bool expired = false;
+
+	while (m_current <= target) {
+		idx = (int)(m_current & LEVEL_MASK);
+
+		if (m_bitmap[0] & (1ULL << idx)) {
+			head = &m_slot[0][idx];
+			while (!list_empty(head)) {
+				entry *e = head->next;
+				list_del(e);
+				e->level = -1;
+				e->slot = -1;
+				list_add_tail(&m_pending, e);
+			}
+			m_bitmap[0] &= ~(1ULL << idx);
+			expired = true;
+		}
+
+		bits = (idx == LEVEL_MASK) ? 0 : (m_bitmap[0] & (~0ULL << (idx + 1)));
+		step = bits ? (unsigned long long)(__builtin_ctzll(bits) - idx) : (unsigned long long)(LEVEL_SIZE - idx);
+
+		if (m_current + step > target + 1)
+			step = target + 1 - m_current;
+
+		m_current += step;
+
+		/*
+		 * cascade as soon as m_current lands on a level boundary, even past target,
+		 * next_expiry() does not look at the current slot of the upper levels
+		 */
+		if (!(m_current & LEVEL_MASK)) {
+			level = 1;
+			while ((level < LEVEL_NUM - 1) && !((m_current >> (LEVEL_BITS * level)) & LEVEL_MASK))
+				level++;
+
+			for (; level >= 1; level--)
+				cascade(level);
+		}
+	}
+
+	return expired;
+}
+
+unsigned long long ctimer_wheel::next_expiry(void)
+{
+	unsigned long long expiry = EXPIRY_NONE;
+	unsigned long long bm;
+	unsigned long long upper;
+	entry *head;
+	entry *e;
+	int level;
+	int cur;
+	int slot;
+
+	if (!list_empty(&m_pending))
+		return m_current;
+
+	for (level = 0; level < LEVEL_NUM; level++) {
+		bm = m_bitmap[level];
+		if (!bm)
+			continue;
+
+		cur = (int)((m_current >> (LEVEL_BITS * level)) & LEVEL_MASK);
+
+		/* level 0 still owes the current tick, advance() cascaded the current slot of upper levels */
+		if (level == 0)
+			upper = bm & (~0ULL << cur);
+		else
+			upper = (cur == LEVEL_MASK) ? 0 : (bm & (~0ULL << (cur + 1)));
+
+		slot = __builtin_ctzll(upper ? upper : bm);
+
+		head = &m_slot[level][slot];
+		for (e = head->next; e != head; e = e->next) {
+			if (e->expires < expiry)
+				expiry = e->expires;
+		}
+	}
+
+	return expiry;
+}
+
+void ctimer_wheel::arm(void)
+{
+	struct itimerspec its;
+	unsigned long long expiry;
+
+	if (m_fd < 0)
+		return;
+
+	expiry = next_expiry();
+	if (expiry == m_armed_expiry)
+		return;
+
+	memset(&its, 0, sizeof(its));
+
+	if (expiry != EXPIRY_NONE) {
+		its.it_value.tv_sec = expiry / 1000;
+		its.it_value.tv_nsec = (expiry % 1000) * 1000000;
+		if (!its.it_value.tv_sec && !its.it_value.tv_nsec)
+			its.it_value.tv_nsec = 1;
+	}
+
+	if (timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+		ERR("timerfd_settime fail , errno : %d\n", errno);
+		return;
+	}
+
+	m_armed_expiry = expiry;
+}
+
+int ctimer_wheel::run(int max_expire)
+{
+	unsigned long long expirations;
+	int expired = 0;
+	entry *e;
+
+	/* without init() nothing is armed, the caller wakes up at next_expiry() itself */
+	if ((m_fd >= 0) && (read(m_fd, &expirations, sizeof(expirations)) == sizeof(expirations)))
+		m_armed_expiry = EXPIRY_NONE;
+
+	advance(m_clock());
+
+	while (!list_empty(&m_pending) && ((max_expire <= 0) || (expired < max_expire))) {
+		e = m_pending.next;
+		list_del(e);
+		m_count--;
+
+		e->cb(e->user_data);
+		expired++;
+	}
+
+	if (expired > 0) {
+		m_wakeups++;
+		m_wakeups_saved += expired - 1;
+	}
+
+	arm();
+
+	return expired;
+}
+//! End of a file
@@ -0,0 +1,107 @@
+/*
+ *  libslp-sensor
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: JuHyun Kim <jh8212.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+
+#ifndef __SAMSUNG_LINUX_SENSOR_CTIMER_WHEEL_H__
+#define __SAMSUNG_LINUX_SENSOR_CTIMER_WHEEL_H__
+
+/*
+ * Hierarchical timer wheel driven by a single timerfd.
+ * Resolution is one millisecond tick, four levels of 64 slots each
+ * cover deadlines up to 2^24 ms (~4.6 hours) ahead.
+ * add(), cancel() and reschedule() are O(1); expiry cascades lazily.
+ * An entry with slack may expire up to slack ms late, so that it shares
+ * a wakeup with the armed expiry or with another entry due within its slack.
+ * set_clock() replaces the CLOCK_MONOTONIC millisecond clock, for tests.
+ */
+class ctimer_wheel {
+public:
+	typedef void (*expire_cb_t)(void *user_data);
+	typedef unsigned long long (*clock_cb_t)(void);
+
+	struct entry {
+		entry *prev;
+		entry *next;
+		unsigned long long expires;
+		unsigned int slack;
+		int level;
+		int slot;
+		expire_cb_t cb;
+		void *user_data;
+
+		entry();
+		bool is_armed(void) const { return prev != 0; }
+	};
+
+	enum {
+		LEVEL_BITS	= 6,
+		LEVEL_SIZE	= 1 << LEVEL_BITS,
+		LEVEL_MASK	= LEVEL_SIZE - 1,
+		LEVEL_NUM	= 4,
+	};
+
+	ctimer_wheel();
+	~ctimer_wheel();
+
+	bool init(void);
+	int get_fd(void) const { return m_fd; }
+	unsigned int count(void) const { return m_count; }
+	unsigned int wakeups(void) const { return m_wakeups; }
+	unsigned int wakeups_saved(void) const { return m_wakeups_saved; }
+
+	static unsigned long long now(void);
+	void set_clock(clock_cb_t clock) { m_clock = clock; }
+
+	void add(entry *e, unsigned int timeout_ms);
+	void add_at(entry *e, unsigned long long expires);
+	void cancel(entry *e);
+	void reschedule(entry *e, unsigned int timeout_ms);
+
+	unsigned long long next_expiry(void);
+	int run(int max_expire);
+
+private:
+	int m_fd;
+	clock_cb_t m_clock;
+	unsigned long long m_current;
+	unsigned long long m_armed_expiry;
+	unsigned int m_count;
+	unsigned int m_wakeups;
+	unsigned int m_wakeups_saved;
+	unsigned long long m_bitmap[LEVEL_NUM];
+	entry m_slot[LEVEL_NUM][LEVEL_SIZE];
+	entry m_pending;
+
+	static void list_init(entry *head);
+	static bool list_empty(entry *head);
+	static void list_add_tail(entry *head, entry *e);
+	static void list_del(entry *e);
+
+	unsigned long long coalesce(unsigned long long expires, unsigned int slack);
+	void place(entry *e);
+	void cascade(int level);
+	bool advance(unsigned long long target);
+	void arm(void);
+};
+
+#endif
+//! End of a file